@@ -21,9 +21,13 @@
 #ifndef _GAZEBO_OBJECT_DISPOSAL_PLUGIN_HH_
 #define _GAZEBO_OBJECT_DISPOSAL_PLUGIN_HH_
 
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <gazebo/common/Plugin.hh>
 #include <gazebo/sensors/sensors.hh>
 #include <gazebo/util/system.hh>
+#include <ignition/math/Box.hh>
 #include <ignition/math/Pose3.hh>
 
 #include "SideContactPlugin.hh"
@@ -55,6 +59,48 @@ namespace gazebo
 
     /// \brief Pose where the object will be teleported.
     protected: ignition::math::Pose3d disposalPose;
+
+    /// \brief If true, disposed models are parked in the shared model pool
+    /// instead of being teleported to the disposal pose
+    protected: bool recycleModels = false;
+
+    /// \brief Mass of every link of a model, used for the center of gravity
+    protected: struct ModelMassTable
+    {
+      /// \brief Model the table was built for
+      physics::ModelPtr model;
+
+      /// \brief Links of the model
+      std::vector<physics::LinkPtr> links;
+
+      /// \brief Mass of each link
+      std::vector<double> masses;
+
+      /// \brief Sum of the masses
+      double totalMass = 0.0;
+    };
+
+    /// \brief Mass tables of the contacting models by scoped model name
+    protected: std::unordered_map<std::string, ModelMassTable> massTables;
+
+    /// \brief Get the mass table of a model, building it if needed.
+    /// \param[in] _model Model to look up.
+    /// \param[in,out] _tables Tables to look up first; the table is moved
+    /// from there into massTables.
+    protected: const ModelMassTable &MassTable(const physics::ModelPtr &_model,
+                 std::unordered_map<std::string, ModelMassTable> &_tables);
+
+    /// \brief Update the cached disposal box if the link moved.
+    protected: void UpdateDisposalBox();
+
+    /// \brief Area above the link in which models are removed (z is unbounded)
+    protected: ignition::math::Box disposalBox;
+
+    /// \brief Pose of the link when disposalBox was computed
+    protected: ignition::math::Pose3d disposalBoxLinkPose;
+
+    /// \brief Whether disposalBox was computed
+    protected: bool disposalBoxValid = false;
   };
 }
 #endif
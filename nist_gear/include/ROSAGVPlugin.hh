@@ -18,10 +18,12 @@
 #define ROS_AGV_PLUGIN_HH_
 
 #include <memory>
+#include <string>
 
 #include <sdf/sdf.hh>
 #include <gazebo/physics/physics.hh>
 #include <gazebo/common/Plugin.hh>
+#include <gazebo/msgs/msgs.hh>
 #include "nist_gear/AGVToAssemblyStation.h" //--custom service
 #include "nist_gear/AGVToKittingStation.h"  //--custom service
 // ROS
@@ -77,11 +79,36 @@ namespace gazebo
     bool OnCommandToKittingStation(nist_gear::AGVToKittingStation::Request &,
                                    nist_gear::AGVToKittingStation::Response &_res);
 
+    /// \brief Receives move requests over gazebo transport (e.g. from the
+    /// AGV dispatcher). The message holds the destination station, either an
+    /// assembly station ("AS1".."AS6") or the AGV's kitting station ("KS").
+    /// \param[in] _msg Destination station.
+  public:
+    void OnDispatchRequest(ConstGzStringPtr &_msg);
+
     /// \brief Called when world update events are received
     /// \param[in] _info Update information provided by the server.
   protected:
     virtual void OnUpdate(const common::UpdateInfo &_info);
 
+    /// \brief Start the animation from the current station of the AGV to a
+    /// destination station.
+    /// \param[in] _destination Station to go to ("KS<N>" or "AS<N>").
+    /// \param[in] _time Current simulation time.
+  protected:
+    void StartMove(const std::string &_destination, const common::Time &_time);
+
+    /// \brief Move the AGV, its tray and the parts locked to the tray to the
+    /// end of the current move (used in fast mode).
+  protected:
+    void TeleportToEndOfMove();
+
+    /// \brief Publish the telemetry of the AGV.
+    /// \param[in] _time Current simulation time.
+    /// \param[in] _arrived True when the AGV just docked to its destination.
+  protected:
+    void PublishTelemetry(const common::Time &_time, bool _arrived);
+
     /// \brief Private data pointer.
   private:
     std::unique_ptr<ROSAGVPluginPrivate> dataPtr;
@@ -21,8 +21,12 @@
 #ifndef _GAZEBO_KIT_TRAY_PLUGIN_HH_
 #define _GAZEBO_KIT_TRAY_PLUGIN_HH_
 
+#include <atomic>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
+#include <ignition/math/Matrix4.hh>
 #include <ros/ros.h>
 #include <std_srvs/Trigger.h>
 #include <tf2_ros/transform_broadcaster.h>
@@ -36,6 +40,7 @@
 #include <nist_gear/ARIAC.hh>
 #include <nist_gear/DetectedShipment.h>
 #include <nist_gear/DetectShipment.h>
+#include <nist_gear/TrayContentEvents.h>
 #include "SideContactPlugin.hh"
 
 namespace gazebo
@@ -73,8 +78,29 @@ namespace gazebo
     /// This will check that only the /gazebo node is subscribed during the competition
     protected: void OnSubscriberConnect(const ros::SingleSubscriberPublisher& pub);
 
-    /// \brief Publish the Kit ROS message
-    protected: void PublishKitMsg();
+    /// \brief Publish the Kit ROS message if the kit changed since the last
+    /// message, or if the keepalive period elapsed.
+    /// \param[in] _simTime Current simulation time.
+    protected: void PublishKitMsg(const common::Time &_simTime);
+
+    /// \brief Whether the kit changed since it was last published, beyond the
+    /// publication tolerances.
+    protected: bool KitChangedSincePublished() const;
+
+    /// \brief Whether two objects differ by more than the publication tolerances
+    protected: bool ObjectMoved(const ariac::KitObject &_a, const ariac::KitObject &_b) const;
+
+    /// \brief Whether two poses differ by more than the publication tolerances
+    protected: bool PoseMoved(const ignition::math::Pose3d &_a,
+                              const ignition::math::Pose3d &_b) const;
+
+    /// \brief Publish the products added, removed or moved since the last
+    /// content event, or a snapshot if one was requested.
+    protected: void PublishContentEvents();
+
+    /// \brief Service that requests a snapshot on the content events topic
+    protected: bool HandleResyncEventsService(
+      ros::ServiceEvent<std_srvs::Trigger::Request, std_srvs::Trigger::Response>& event);
 
     /// \brief Service for locking the models to the tray and disabling updates
     protected: void HandleLockModelsRequest(ConstGzStringPtr &_msg);
@@ -135,10 +161,79 @@ namespace gazebo
     /// \brief Parts to ignore (will be published as faulty in tray msgs)
     /// The namespace of the part (e.g. bin7) is ignored.
     /// e.g. if model_name1 is faulty, either bin7|model_name1 or bin6|model_name1 will be considered faulty
-    protected: std::vector<std::string> faultyPartNames;
+    protected: std::unordered_set<std::string> faultyPartNames;
+
+    /// \brief Kit object of a contacting model along with the world poses it
+    /// was computed from
+    protected: struct CachedKitObject
+    {
+      /// \brief World pose of the model when the object was computed
+      ignition::math::Pose3d modelWorldPose;
+
+      /// \brief Gazebo id of the model
+      uint32_t modelId;
+
+      /// \brief Scoped name of the model
+      std::string modelName;
+
+      /// \brief Object with its pose in the frame of the tray
+      ariac::KitObject object;
+    };
+
+    /// \brief Kit objects of the contacting models, by scoped model name.
+    /// An object is only recomputed when its model moved.
+    protected: std::unordered_map<std::string, CachedKitObject> kitObjectCache;
+
+    /// \brief World pose of the tray the cached objects are relative to.
+    /// The whole cache is dropped when the tray moves.
+    protected: ignition::math::Pose3d cachedTrayPose;
+
+    /// \brief Inverse of the transform of cachedTrayPose
+    protected: ignition::math::Matrix4d cachedTrayInverse;
 
     /// \brief Gazebo subscriber to the lock models topic
     protected: transport::SubscriberPtr lockModelsSub;
+
+    /// \brief Kit as last published on the Kit ROS topic
+    protected: ariac::Kit publishedKit;
+
+    /// \brief Whether the kit was ever published
+    protected: bool kitPublished = false;
+
+    /// \brief Sequence number of the last published Kit ROS message
+    protected: uint32_t kitSequence = 0;
+
+    /// \brief Last time (sim time) the Kit ROS message was published
+    protected: common::Time lastKitPublishTime;
+
+    /// \brief Position change (m) of a product that triggers a publication
+    protected: double publishPositionTolerance = 0.001;
+
+    /// \brief Orientation change (rad) of a product that triggers a publication
+    protected: double publishOrientationTolerance = 0.01;
+
+    /// \brief Period (s) after which an unchanged kit is published again.
+    /// A non-positive value disables the keepalive.
+    protected: double keepalivePeriod = 1.0;
+
+    /// \brief Publisher for the content events
+    protected: ros::Publisher contentEventsPub;
+
+    /// \brief ROS service that requests a content events snapshot
+    public: ros::ServiceServer resyncEventsServer;
+
+    /// \brief Products as last announced on the content events topic, by model id
+    protected: std::unordered_map<uint32_t, CachedKitObject> announcedObjects;
+
+    /// \brief Sequence number of the last content events message
+    protected: uint32_t contentEventsSequence = 0;
+
+    /// \brief Whether the next content events message must be a snapshot
+    protected: std::atomic<bool> resyncRequested{true};
+
+    /// \brief If true, the content events don't reveal whether the products
+    /// are faulty nor their exact pose. Set during the competition.
+    protected: bool hideContentDetails = false;
   };
 }
 #endif
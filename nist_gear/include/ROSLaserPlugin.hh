@@ -19,6 +19,7 @@
 #define ROS_LASER_PLUGIN_HH
 
 #include <string>
+#include <vector>
 
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
@@ -26,7 +27,9 @@
 #include <ros/ros.h>
 #include <ros/advertise_options.h>
 #include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
 
+#include <ignition/math/Pose3.hh>
 #include <sdf/Param.hh>
 #include <gazebo/physics/physics.hh>
 #include <gazebo/transport/TransportTypes.hh>
@@ -34,12 +37,11 @@
 #include <gazebo/common/Time.hh>
 #include <gazebo/common/Plugin.hh>
 #include <gazebo/common/Events.hh>
+#include <gazebo/msgs/msgs.hh>
 #include <gazebo/sensors/SensorTypes.hh>
 #include <gazebo/plugins/RayPlugin.hh>
 #include <gazebo_plugins/gazebo_ros_utils.h>
 
-#include <gazebo_plugins/PubQueue.h>
-
 namespace gazebo
 {
   class ROSLaserPlugin : public RayPlugin
@@ -69,11 +71,22 @@ namespace gazebo
     /// \brief pointer to ros node
     private: ros::NodeHandle* rosnode_;
     private: ros::Publisher pub_;
-    private: PubQueue<sensor_msgs::LaserScan>::Ptr pub_queue_;
+
+    /// \brief Publisher of the points in the sensor frame
+    private: ros::Publisher cloud_pub_;
+
+    /// \brief Publisher of the points in the world frame
+    private: ros::Publisher world_cloud_pub_;
 
     /// \brief topic name
     private: std::string topic_name_;
 
+    /// \brief topic of the points in the sensor frame, empty if not published
+    private: std::string cloud_topic_name_;
+
+    /// \brief topic of the points in the world frame, empty if not published
+    private: std::string world_cloud_topic_name_;
+
     /// \brief frame transform name, should match link name
     private: std::string frame_name_;
 
@@ -91,6 +104,62 @@ namespace gazebo
     private: gazebo::transport::SubscriberPtr laser_scan_sub_;
     private: void OnScan(ConstLaserScanStampedPtr &_msg);
 
+    /// \brief Compute the points of a scan in the sensor frame.
+    /// Rays that hit nothing give NaN points.
+    /// \return False if the scan doesn't match its own geometry
+    private: bool ProjectScan(const msgs::LaserScan &_scan);
+
+    /// \brief Recompute the direction of every ray if the scan geometry
+    /// changed
+    private: void UpdateRayTable(const msgs::LaserScan &_scan);
+
+    /// \brief Fill a cloud with the points computed by ProjectScan
+    /// \param[in] _pose Pose of the sensor in the cloud's frame, or null to
+    /// keep the points in the sensor frame
+    private: void FillCloud(sensor_msgs::PointCloud2 &_cloud,
+      const ros::Time &_stamp, const std::string &_frame,
+      unsigned int _width, unsigned int _height,
+      const ignition::math::Pose3d *_pose);
+
+    /// \brief Messages reused from one scan to the next. Messages are
+    /// published as shared pointers; a pooled message is reused once
+    /// roscpp and the intra-process subscribers have released it.
+    private: std::vector<sensor_msgs::LaserScanPtr> scan_msgs_;
+
+    /// \brief Index of the pooled message to try first
+    private: size_t next_scan_msg_ = 0;
+
+    /// \brief Clouds in the sensor frame reused from one scan to the next
+    private: std::vector<sensor_msgs::PointCloud2Ptr> cloud_msgs_;
+
+    /// \brief Index of the pooled cloud in the sensor frame to try first
+    private: size_t next_cloud_msg_ = 0;
+
+    /// \brief Clouds in the world frame reused from one scan to the next
+    private: std::vector<sensor_msgs::PointCloud2Ptr> world_cloud_msgs_;
+
+    /// \brief Index of the pooled cloud in the world frame to try first
+    private: size_t next_world_cloud_msg_ = 0;
+
+    /// \brief Scan geometry the ray table was computed for
+    private: unsigned int ray_count_ = 0;
+    private: unsigned int ray_vertical_count_ = 0;
+    private: double ray_angle_min_ = 0;
+    private: double ray_angle_step_ = 0;
+    private: double ray_vertical_angle_min_ = 0;
+    private: double ray_vertical_angle_step_ = 0;
+
+    /// \brief Unit direction of every ray in the sensor frame, in the order
+    /// of the ranges
+    private: std::vector<float> ray_x_;
+    private: std::vector<float> ray_y_;
+    private: std::vector<float> ray_z_;
+
+    /// \brief Points of the last scan in the sensor frame
+    private: std::vector<float> point_x_;
+    private: std::vector<float> point_y_;
+    private: std::vector<float> point_z_;
+
     /// \brief Called when an activation/deactivation message received
     public: void OnActivationMsg(ConstGzStringPtr &_msg);
 
@@ -102,9 +171,6 @@ namespace gazebo
 
     /// \brief If true, publish to the ROS topic
     private: bool publishing_ = true;
-
-    /// \brief prevents blocking
-    private: PubMultiQueue pmq;
   };
 }
 #endif
@@ -18,11 +18,17 @@
 #ifndef _ROS_LOGICAL_CAMERA_PLUGIN_HH_
 #define _ROS_LOGICAL_CAMERA_PLUGIN_HH_
 
+#include <atomic>
+#include <mutex>
+#include <random>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <sdf/sdf.hh>
 
+#include "gazebo/common/Events.hh"
 #include "gazebo/common/Plugin.hh"
 #include "gazebo/common/UpdateInfo.hh"
 #include "gazebo/msgs/logical_camera_image.pb.h"
@@ -31,12 +37,15 @@
 #include "gazebo/transport/Node.hh"
 #include "gazebo/transport/Subscriber.hh"
 #include "gazebo/transport/TransportTypes.hh"
+#include <boost/weak_ptr.hpp>
 #include <ignition/math/Pose3.hh>
 
+#include "nist_gear/LogicalCameraAggregator.hh"
+
 // ROS
 #include "nist_gear/LogicalCameraImage.h"
 #include <ros/ros.h>
-#include <tf/transform_broadcaster.h>
+#include <tf2_msgs/TFMessage.h>
 
 namespace gazebo
 {
@@ -76,29 +85,164 @@ namespace gazebo
     /// \param[in] _msg The logical camera image
     public: void OnImage(ConstLogicalCameraImagePtr &_msg);
 
+    /// \brief Publish a logical camera image
+    /// \param[in] _msg The logical camera image
+    /// \param[in] imageTime Simulation time of the image, used to stamp the
+    /// TF frames
+    protected: void ProcessImage(ConstLogicalCameraImagePtr &_msg,
+      const common::Time &imageTime);
+
+    /// \brief A nested model of a detected model
+    protected: struct NestedModel
+    {
+      /// \brief The nested model
+      boost::weak_ptr<physics::Model> model;
+
+      /// \brief Name of the nested model
+      std::string name;
+    };
+
+    /// \brief What the camera publishes about a model, derived from its name
+    protected: struct DetectedModel
+    {
+      /// \brief Type of the model
+      std::string type;
+
+      /// \brief Type published in the image (anonymized or not)
+      std::string typeToUse;
+
+      /// \brief Name used in the TF frame (anonymized or not)
+      std::string nameToUse;
+
+      /// \brief TF frame of the model
+      std::string frameId;
+
+      /// \brief Whether the model should be published
+      bool publish = true;
+
+      /// \brief Whether nestedModels was looked up
+      bool nestedResolved = false;
+
+      /// \brief Nested models of the model
+      std::vector<NestedModel> nestedModels;
+    };
+
+    /// \brief Get what is published about a model, computing it on the first
+    /// detection of the model
+    /// \param[in] modelName Scoped name of the model
+    protected: DetectedModel & Detected(const std::string & modelName);
+
     /// \brief Determine if the model is one that should be published
     protected: bool ModelToPublish(const std::string & modelName, const std::string & modelType);
 
+    /// \brief Noise applied to the position or the orientation of the models
+    protected: struct NoiseStream
+    {
+      /// \brief The noise model, null if there is no noise
+      sensors::NoisePtr noise;
+
+      /// \brief Whether the noise is gaussian and drawn in batches from
+      /// noiseGenerator; otherwise the noise model is applied
+      bool batched = false;
+
+      /// \brief Bias of the gaussian noise
+      double bias = 0.0;
+
+      /// \brief Distribution of the gaussian noise, without the bias
+      std::normal_distribution<double> distribution;
+
+      /// \brief Samples drawn in the last batch
+      std::vector<double> samples;
+
+      /// \brief Index of the next unused sample
+      size_t next = 0;
+    };
+
+    /// \brief Create the noise model of an SDF <noise> element
+    /// \param[in] _noiseElem The <noise> element
+    /// \param[out] stream The noise to set up
+    protected: void LoadNoise(sdf::ElementPtr _noiseElem, NoiseStream & stream);
+
+    /// \brief Apply noise to a value
+    /// \param[in] stream The noise to apply
+    /// \param[in] value The value
+    /// \return The noisy value
+    protected: double ApplyNoise(NoiseStream & stream, double value);
+
     /// \brief Add noise to a model pose
     protected: void AddNoise(ignition::math::Pose3d & pose);
 
     /// \brief Add model info to the message to be published
     protected: void AddModelToMsg(
-      const std::string & modelType, const ignition::math::Pose3d & modelPose,
-      nist_gear::LogicalCameraImage & imageMsg);
-
-    /// \brief Publish the TF frame of a model
-    protected: void PublishTF(
+      const std::string & modelType, const ignition::math::Pose3d & modelPose);
+
+    /// \brief Describe the models of an image for the debug output
+    /// \param[in] _msg Image whose models were processed
+    /// \return One line per model, saying whether it is published
+    protected: std::string DescribeModels(ConstLogicalCameraImagePtr &_msg);
+
+    /// \brief Add a model to the detections reported to the
+    /// LogicalCameraAggregator for the current image
+    /// \param[in] modelName Name of the model, as in its TF frame
+    /// \param[in] modelType Type of the model
+    /// \param[in] worldPose Pose of the model in the world frame
+    protected: void AddDetection(const std::string & modelName,
+      const std::string & modelType, const ignition::math::Pose3d & worldPose);
+
+    /// \brief Add the TF frame of a model to the transforms of the current
+    /// image. They are all published at once by OnImage().
+    protected: void AddTF(
       const ignition::math::Pose3d & pose, const std::string & parentFrame, const std::string & frame);
 
     /// \brief Called when an activation/deactivation message received
     public: void OnActivationMsg(ConstGzStringPtr &_msg);
 
+    /// \brief Called when the image or the fused detections get a subscriber
+    protected: void OnConsumerConnect();
+
+    /// \brief Called when the image or the fused detections lose a subscriber
+    protected: void OnConsumerDisconnect();
+
+    /// \brief Wake the sensor up and subscribe to its images if the camera
+    /// isn't deactivated and, for a lazy camera, has subscribers. Put it to
+    /// sleep otherwise. Expects activityMutex to be locked.
+    protected: void UpdateActivity();
+
     /// \brief Subscriber to the activation topic.
     protected: transport::SubscriberPtr activationSub;
 
-    /// \brief If true, publish to the ROS topic
-    protected: bool publishing = true;
+    /// \brief If true, publish to the ROS topic. Written under activityMutex,
+    /// read by the image callbacks without it.
+    protected: std::atomic<bool> publishing{true};
+
+    /// \brief Number of subscribers of the image and of the fused detections
+    protected: int consumerCount = 0;
+
+    /// \brief Id of the camera in the LogicalPerceptionEngine, 0 when the
+    /// images come from the sensor
+    protected: unsigned int perceptionId = 0;
+
+    /// \brief Id of the camera in the LogicalCameraAggregator, 0 if the
+    /// camera doesn't contribute to the fused detections
+    protected: unsigned int aggregatorId = 0;
+
+    /// \brief Detections reported to the LogicalCameraAggregator, reused from
+    /// one image to the next
+    protected: std::vector<LogicalCameraDetection> detections;
+
+    /// \brief Number of entries of detections filled for the current image
+    protected: size_t detectionCount = 0;
+
+    /// \brief Protects publishing, consumerCount and imageSub
+    protected: std::mutex activityMutex;
+
+    /// \brief If true, publish the TF frames of the models while the camera
+    /// is active
+    protected: bool publishTF = true;
+
+    /// \brief If true, the camera sleeps while neither its image nor the
+    /// fused detections have subscribers, and publishes no TF frames then
+    protected: bool lazy = false;
 
     /// \brief Node for communication with gazebo
     protected: transport::NodePtr node;
@@ -115,6 +259,31 @@ namespace gazebo
     /// \brief ROS publisher for the logical camera image
     protected: ros::Publisher imagePub;
 
+    /// \brief Image being published, reused from one image to the next
+    protected: nist_gear::LogicalCameraImage imageMsg;
+
+    /// \brief Number of entries of imageMsg.models filled for the current image
+    protected: size_t imageModelCount = 0;
+
+    /// \brief What is published about the models detected so far, by name
+    protected: std::unordered_map<std::string, DetectedModel> detectedModels;
+
+    /// \brief Set when a model is inserted or deleted, to look up the nested
+    /// models of the detected models again
+    protected: std::atomic<bool> nestedModelsStale{false};
+
+    /// \brief Connection to the entity insertion event
+    protected: event::ConnectionPtr addEntityConnection;
+
+    /// \brief Connection to the entity deletion event
+    protected: event::ConnectionPtr deleteEntityConnection;
+
+    /// \brief TF frame of the camera
+    protected: std::string cameraFrameId;
+
+    /// \brief TF frames of the kit trays of agv1 and agv2
+    protected: std::string kitTrayFrameIds[2];
+
     /// \brief Prefix for the model TF frames published
     protected: std::string modelFramePrefix;
 
@@ -122,23 +291,37 @@ namespace gazebo
     protected: bool onlyPublishKnownModels;
 
     /// \brief Whitelist of the known model types to detect
-    protected: std::vector<std::string> knownModelTypes;
+    protected: std::unordered_set<std::string> knownModelTypes;
 
     /// \brief Whitelist of known models by name (independent of the namespace (e.g. bin7)).
     /// e.g. if model_name1 is whitelisted, both bin7|model_name1 and bin6|model_name1 will be published
-    protected: std::vector<std::string> knownModelNames;
+    protected: std::unordered_set<std::string> knownModelNames;
 
     /// \brief If true, detected model type will be anonymized
     protected: bool anonymizeModels;
 
-    /// \brief Map of noise IDs to noise models
-    protected: std::map<std::string, sensors::NoisePtr> noiseModels;
+    /// \brief Noise applied to the position of the models
+    protected: NoiseStream positionNoise;
+
+    /// \brief Noise applied to the orientation of the models
+    protected: NoiseStream orientationNoise;
+
+    /// \brief Generator of the gaussian noise, seeded with <noise_seed> (the
+    /// seed of the simulation by default)
+    protected: std::mt19937 noiseGenerator;
 
     /// \brief Pose of kit trays w.r.t. their parent AGV
     protected: ignition::math::Pose3d kitTrayToAgv;
 
-    /// \brief TF broadcaster for model frames
-    protected: boost::shared_ptr<tf::TransformBroadcaster> transformBroadcaster;
+    /// \brief ROS publisher for the TF frames of the models
+    protected: ros::Publisher tfPub;
+
+    /// \brief Transforms of the current image, stamped with its simulation
+    /// time and published in a single message
+    protected: tf2_msgs::TFMessage tfMsg;
+
+    /// \brief Number of entries of tfMsg.transforms filled for the current image
+    protected: size_t tfCount = 0;
   };
 }
 #endif
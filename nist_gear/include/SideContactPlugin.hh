@@ -21,6 +21,10 @@
 #ifndef _GAZEBO_SIDE_CONTACT_PLUGIN_HH_
 #define _GAZEBO_SIDE_CONTACT_PLUGIN_HH_
 
+#include <set>
+#include <string>
+#include <vector>
+
 #include <gazebo/common/Plugin.hh>
 #include <gazebo/common/Time.hh>
 #include <gazebo/common/UpdateInfo.hh>
@@ -29,6 +33,7 @@
 #include <gazebo/transport/Node.hh>
 #include <gazebo/transport/Publisher.hh>
 #include <gazebo/util/system.hh>
+#include "nist_gear/ContactDispatcher.hh"
 
 namespace gazebo
 {
@@ -50,6 +55,10 @@ namespace gazebo
     /// \brief Callback that recieves the contact sensor's messages.
     protected: virtual void OnContactsReceived(ConstContactsPtr& _msg);
 
+    /// \brief Callback that receives the contacts of the watched collision
+    /// from the ContactDispatcher.
+    protected: virtual void OnContactRecords(const std::vector<ContactRecord> &_records);
+
     /// \brief Called when world update events are received
     /// \param[in] _info Update information provided by the server.
     protected: virtual void OnUpdate(const common::UpdateInfo &_info);
@@ -82,14 +91,23 @@ namespace gazebo
     /// \brief Subscriber for the contact topic
     protected: transport::SubscriberPtr contactSub;
 
-    /// \brief Contacts msg received
-    protected: msgs::Contacts newestContactsMsg;
+    /// \brief Contacts msg received. The message published by the sensor is
+    /// shared, not copied.
+    protected: ConstContactsPtr newestContactsMsg;
 
     /// \brief Mutex for protecting contacts msg
     protected: mutable boost::mutex mutex;
 
     /// \brief Flag for new contacts message
-    protected: bool newMsg;
+    protected: bool newMsg = false;
+
+    /// \brief Id of the ContactDispatcher listener, 0 when contacts are
+    /// received from the contact sensor topic
+    protected: unsigned int contactListenerId = 0;
+
+    /// \brief Links contacting the watched collision, as received from the
+    /// ContactDispatcher
+    protected: std::set<physics::LinkPtr> dispatchedLinks;
 
     /// \brief Name of the collision of the parent's link
     protected: std::string collisionName;
@@ -113,7 +131,7 @@ namespace gazebo
     /// \brief Determine which models are in contact with the side of the parent link
     protected: virtual void CalculateContactingModels();
 
-    /// \brief Teleport all contacting models to a predetermined location
+    /// \brief Park all contacting models in the shared model pool
     protected: virtual void ClearContactingModels();
 
     /// \brief Determine whether is time to give the plugin an update based on
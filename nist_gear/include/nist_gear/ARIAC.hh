@@ -315,6 +315,18 @@ namespace ariac
     };
   };
 
+  /// \brief Lane node of an AGV station: 0 for a kitting station, 1..3 for
+  /// AS1/AS4, AS2/AS5 and AS3/AS6. -1 if unknown.
+  int AGVLaneNode(const std::string &_station)
+  {
+    if (_station.compare(0, 2, "KS") == 0)
+      return 0;
+    if (_station.size() == 3 && _station.compare(0, 2, "AS") == 0 &&
+        _station[2] >= '1' && _station[2] <= '6')
+      return (_station[2] - '1') % 3 + 1;
+    return -1;
+  }
+
   /// \brief Determine the model name without namespace
   std::string TrimNamespace(const std::string &modelName)
   {
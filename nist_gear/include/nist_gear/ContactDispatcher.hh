@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _GAZEBO_CONTACT_DISPATCHER_HH_
+#define _GAZEBO_CONTACT_DISPATCHER_HH_
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <gazebo/common/Events.hh>
+#include <gazebo/common/Time.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+#include <ignition/math/Vector3.hh>
+
+namespace gazebo
+{
+  /// \brief A contact involving a watched collision.
+  struct ContactRecord
+  {
+    /// \brief The watched collision (collision1 for catch-all listeners).
+    physics::CollisionPtr collision;
+
+    /// \brief The other collision of the contact.
+    physics::CollisionPtr other;
+
+    /// \brief Normal of the first contact point, oriented as if the watched
+    /// collision were collision1 of the contact.
+    ignition::math::Vector3d normal;
+
+    /// \brief Number of contact points.
+    int count = 0;
+
+    /// \brief Simulation time of the contact.
+    common::Time time;
+  };
+
+  /// \brief Process-wide fan-out of the physics contacts.
+  ///
+  /// Once enabled by ContactDispatcherPlugin, the dispatcher reads the
+  /// contacts of the contact manager once at the end of every step, and hands
+  /// each listener the contacts of the collisions it registered, without
+  /// going through gazebo transport. Listeners are called from the physics
+  /// thread on every step, with an empty batch if there was no contact, and
+  /// must not register or unregister from within the callback.
+  class GAZEBO_VISIBLE ContactDispatcher
+  {
+    /// \brief Callback receiving the contacts of a step.
+    public: using Listener = std::function<void(const std::vector<ContactRecord> &)>;
+
+    /// \brief Get the dispatcher shared by all the plugins.
+    public: static ContactDispatcher &Instance();
+
+    /// \brief Start dispatching the contacts of a world.
+    /// \param[in] _world World to read the contacts from.
+    public: void Enable(const physics::WorldPtr &_world);
+
+    /// \brief Whether the dispatcher was enabled. Plugins that find it
+    /// disabled keep subscribing to the contact topics.
+    public: bool Enabled();
+
+    /// \brief Register a listener for the contacts of some collisions.
+    /// \param[in] _collisions Collisions to watch.
+    /// \param[in] _listener Callback receiving the contacts of those collisions.
+    /// \returns Id to pass to Unregister().
+    public: unsigned int Register(const std::vector<physics::CollisionPtr> &_collisions,
+                                  const Listener &_listener);
+
+    /// \brief Register a listener for all the contacts of the world.
+    /// \param[in] _listener Callback receiving all the contacts.
+    /// \returns Id to pass to Unregister().
+    public: unsigned int RegisterAll(const Listener &_listener);
+
+    /// \brief Remove a listener.
+    /// \param[in] _id Id returned when the listener was registered.
+    public: void Unregister(unsigned int _id);
+
+    /// \brief Constructor. Use Instance().
+    private: ContactDispatcher() = default;
+
+    /// \brief Read the contacts of the step and call the listeners.
+    private: void OnWorldUpdateEnd();
+
+    /// \brief A registered listener.
+    private: struct ListenerEntry
+    {
+      /// \brief Callback.
+      Listener callback;
+
+      /// \brief Ids of the watched collisions, empty for catch-all listeners.
+      std::vector<uint32_t> collisionIds;
+
+      /// \brief Contacts of the current step.
+      std::vector<ContactRecord> batch;
+    };
+
+    /// \brief World the contacts are read from.
+    private: physics::WorldPtr world;
+
+    /// \brief Listeners by id.
+    private: std::unordered_map<unsigned int, ListenerEntry> listeners;
+
+    /// \brief Ids of the listeners watching each collision, by collision id.
+    private: std::unordered_map<uint32_t, std::vector<unsigned int>> byCollision;
+
+    /// \brief Ids of the catch-all listeners.
+    private: std::vector<unsigned int> catchAll;
+
+    /// \brief Id of the next listener.
+    private: unsigned int nextId = 1;
+
+    /// \brief Protects the listeners.
+    private: std::mutex mutex;
+
+    /// \brief Connection to the end of the world update.
+    private: event::ConnectionPtr updateConnection;
+  };
+}
+#endif
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GAZEBO_CONTACT_DISPATCHER_PLUGIN_HH_
+#define GAZEBO_CONTACT_DISPATCHER_PLUGIN_HH_
+
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+#include <sdf/sdf.hh>
+
+namespace gazebo
+{
+  /// \brief A plugin that enables the ContactDispatcher for the world.
+  ///
+  /// It must be listed before the world plugins using contacts (e.g. the
+  /// task manager). Model plugins are always loaded after it. Without this
+  /// plugin, SideContactPlugin, VacuumGripperPlugin and the task manager
+  /// subscribe to the gazebo contact topics as before.
+  class GAZEBO_VISIBLE ContactDispatcherPlugin : public WorldPlugin
+  {
+    /// \brief Constructor.
+  public:
+    ContactDispatcherPlugin();
+
+    /// \brief Destructor.
+  public:
+    virtual ~ContactDispatcherPlugin();
+
+    // Documentation inherited.
+  public:
+    virtual void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+  };
+} // namespace gazebo
+#endif
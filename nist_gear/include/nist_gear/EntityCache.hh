@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _GAZEBO_ENTITY_CACHE_HH_
+#define _GAZEBO_ENTITY_CACHE_HH_
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <boost/weak_ptr.hpp>
+#include <gazebo/common/Events.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+
+namespace gazebo
+{
+  /// \brief Process-wide cache of the world's entities by scoped name.
+  ///
+  /// physics::World::EntityByName walks the whole entity tree. Plugins that
+  /// resolve names for every contact or every detected model should go
+  /// through this cache instead. Entities are held by weak pointers and the
+  /// entries of a model (and of everything scoped under it) are dropped when
+  /// a model with that name is inserted or deleted. Failed lookups are not
+  /// cached. The cache is safe to use from any thread.
+  class GAZEBO_VISIBLE EntityCache
+  {
+    /// \brief Get the cache shared by all the plugins.
+    public: static EntityCache &Instance();
+
+    /// \brief Find an entity by its scoped name.
+    /// \param[in] _world World the entity lives in.
+    /// \param[in] _name Scoped name of the entity.
+    /// \returns The entity, or null if it doesn't exist.
+    public: physics::EntityPtr EntityByName(const physics::WorldPtr &_world,
+                                            const std::string &_name);
+
+    /// \brief Find a model by its scoped name.
+    /// \returns The model, or null if it doesn't exist or isn't a model.
+    public: physics::ModelPtr ModelByName(const physics::WorldPtr &_world,
+                                          const std::string &_name);
+
+    /// \brief Find a link by its scoped name.
+    /// \returns The link, or null if it doesn't exist or isn't a link.
+    public: physics::LinkPtr LinkByName(const physics::WorldPtr &_world,
+                                        const std::string &_name);
+
+    /// \brief Find a collision by its scoped name.
+    /// \returns The collision, or null if it doesn't exist or isn't a collision.
+    public: physics::CollisionPtr CollisionByName(const physics::WorldPtr &_world,
+                                                  const std::string &_name);
+
+    /// \brief Drop the entries of an entity and of all the entities scoped
+    /// under it.
+    /// \param[in] _name Scoped name of the entity.
+    public: void Invalidate(const std::string &_name);
+
+    /// \brief Drop all the entries.
+    public: void Clear();
+
+    /// \brief Constructor. Use Instance().
+    private: EntityCache();
+
+    /// \brief Cached entities by scoped name.
+    private: std::unordered_map<std::string, boost::weak_ptr<physics::Entity>> entities;
+
+    /// \brief Protects the entities.
+    private: std::mutex mutex;
+
+    /// \brief Connection to the entity insertion event.
+    private: event::ConnectionPtr addEntityConnection;
+
+    /// \brief Connection to the entity deletion event.
+    private: event::ConnectionPtr deleteEntityConnection;
+  };
+}
+#endif
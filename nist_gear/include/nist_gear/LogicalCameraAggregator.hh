@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _GAZEBO_LOGICAL_CAMERA_AGGREGATOR_HH_
+#define _GAZEBO_LOGICAL_CAMERA_AGGREGATOR_HH_
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <gazebo/common/Time.hh>
+#include <ignition/math/Pose3.hh>
+
+namespace gazebo
+{
+  /// \brief A model seen by a logical camera.
+  struct LogicalCameraDetection
+  {
+    /// \brief Name of the model, as in the TF frames of the camera.
+    std::string name;
+
+    /// \brief Type of the model.
+    std::string type;
+
+    /// \brief Pose of the model in the world frame, noise included.
+    ignition::math::Pose3d pose;
+  };
+
+  /// \brief A model seen by one or more logical cameras.
+  struct FusedDetection
+  {
+    /// \brief The most recent detection of the model.
+    LogicalCameraDetection detection;
+
+    /// \brief Simulation time of the image of the detection.
+    common::Time time;
+
+    /// \brief Cameras that saw the model.
+    std::vector<std::string> cameras;
+  };
+
+  /// \brief Process-wide merge of the detections of the logical cameras.
+  ///
+  /// Each ROSLogicalCameraPlugin reports the models it publishes, in the
+  /// world frame, whenever it publishes an image. The detections of a camera
+  /// replace its previous ones, and are dropped when the camera is
+  /// deactivated (sensor blackout). Fuse() merges the detections of all the
+  /// cameras by model name. While nobody consumes the fused detections, the
+  /// cameras don't report anything. While somebody does, the cameras are
+  /// kept awake.
+  class GAZEBO_VISIBLE LogicalCameraAggregator
+  {
+    /// \brief Callback waking a camera up (true) or letting it sleep (false).
+    public: using ActivationCallback = std::function<void(bool)>;
+
+    /// \brief Get the aggregator shared by all the plugins.
+    public: static LogicalCameraAggregator &Instance();
+
+    /// \brief Register a camera.
+    /// \param[in] _camera Name of the camera.
+    /// \param[in] _onActivation Called when the fused detections gain their
+    /// first consumer or lose their last one. Called right away if they
+    /// already have consumers.
+    /// \returns Id to pass to Unregister().
+    public: unsigned int Register(const std::string &_camera,
+                                  const ActivationCallback &_onActivation);
+
+    /// \brief Remove a camera and drop its detections.
+    /// \param[in] _id Id returned when the camera was registered.
+    public: void Unregister(unsigned int _id);
+
+    /// \brief Whether the cameras should report their detections.
+    public: bool Wanted() const;
+
+    /// \brief Set whether the fused detections have consumers.
+    /// \param[in] _wanted True if they have consumers.
+    public: void SetWanted(bool _wanted);
+
+    /// \brief Replace the detections of a camera.
+    /// \param[in] _id Id of the camera.
+    /// \param[in] _time Simulation time of the image.
+    /// \param[in] _detections Models seen by the camera.
+    public: void Report(unsigned int _id, const common::Time &_time,
+                        const std::vector<LogicalCameraDetection> &_detections);
+
+    /// \brief Drop the detections of a camera.
+    /// \param[in] _id Id of the camera.
+    public: void Clear(unsigned int _id);
+
+    /// \brief Merge the detections of all the cameras by model name, keeping
+    /// the most recent detection of each model.
+    /// \param[in] _now Current simulation time.
+    /// \param[in] _maxAge Detections older than this are ignored.
+    /// \param[out] _fused The fused detections, sorted by model name.
+    public: void Fuse(const common::Time &_now, const common::Time &_maxAge,
+                      std::vector<FusedDetection> &_fused);
+
+    /// \brief Constructor. Use Instance().
+    private: LogicalCameraAggregator() = default;
+
+    /// \brief A registered camera.
+    private: struct CameraEntry
+    {
+      /// \brief Name of the camera.
+      std::string name;
+
+      /// \brief Activation callback.
+      ActivationCallback onActivation;
+
+      /// \brief Simulation time of the last report.
+      common::Time time;
+
+      /// \brief Detections of the last report.
+      std::vector<LogicalCameraDetection> detections;
+    };
+
+    /// \brief Cameras by id.
+    private: std::unordered_map<unsigned int, CameraEntry> cameras;
+
+    /// \brief Index in the fused detections of each model, by name. Reused
+    /// by Fuse().
+    private: std::unordered_map<std::string, size_t> fusedIndex;
+
+    /// \brief Id of the next camera.
+    private: unsigned int nextId = 1;
+
+    /// \brief Whether the fused detections have consumers.
+    private: std::atomic<bool> wanted{false};
+
+    /// \brief Protects the cameras and the fused index.
+    private: std::mutex mutex;
+
+    /// \brief Serializes the registrations and the activation changes, which
+    /// call back into the cameras without holding the mutex.
+    private: std::mutex activationMutex;
+  };
+}
+#endif
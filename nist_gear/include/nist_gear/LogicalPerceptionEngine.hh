@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _GAZEBO_LOGICAL_PERCEPTION_ENGINE_HH_
+#define _GAZEBO_LOGICAL_PERCEPTION_ENGINE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/weak_ptr.hpp>
+#include <gazebo/common/Events.hh>
+#include <gazebo/common/Time.hh>
+#include <gazebo/msgs/logical_camera_image.pb.h>
+#include <gazebo/physics/PhysicsTypes.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+
+namespace gazebo
+{
+  /// \brief Frustum and rate of a logical camera evaluated by the
+  /// LogicalPerceptionEngine.
+  struct LogicalCameraParams
+  {
+    /// \brief Link the camera is attached to.
+    physics::LinkPtr link;
+
+    /// \brief Scoped name of the top level model the camera belongs to. Like
+    /// a logical camera sensor, the camera doesn't report it.
+    std::string parentModel;
+
+    /// \brief Pose of the camera relative to the link. The camera looks
+    /// along its +X axis.
+    ignition::math::Pose3d pose;
+
+    /// \brief Near clip distance.
+    double nearClip = 0.0;
+
+    /// \brief Far clip distance.
+    double farClip = 1.0;
+
+    /// \brief Horizontal field of view, in radians.
+    double horizontalFov = 1.0;
+
+    /// \brief Ratio of the horizontal and vertical fields of view.
+    double aspectRatio = 1.0;
+
+    /// \brief Time between two images, zero for an image every step.
+    common::Time period;
+  };
+
+  /// \brief Frustum of a logical camera in the world frame.
+  class GAZEBO_VISIBLE LogicalCameraFrustum
+  {
+    /// \brief Constructor.
+    /// \param[in] _params Clip distances and fields of view of the camera.
+    /// \param[in] _pose Pose of the camera in the world frame. The camera
+    /// looks along its +X axis.
+    public: LogicalCameraFrustum(const LogicalCameraParams &_params,
+                                 const ignition::math::Pose3d &_pose);
+
+    /// \brief Flag the boxes that are entirely outside the frustum, with the
+    /// same test as ignition::math::Frustum::Contains. The boxes are passed
+    /// as one array per coordinate so that the test vectorizes.
+    /// \param[in] _count Number of boxes.
+    /// \param[in] _min Minimum corners of the boxes, one array per axis.
+    /// \param[in] _max Maximum corners of the boxes, one array per axis.
+    /// \param[in,out] _outside Set to 1 for the boxes outside the frustum,
+    /// left untouched for the others.
+    public: void FlagOutside(size_t _count, const double *const _min[3],
+                             const double *const _max[3], uint8_t *_outside) const;
+
+    /// \brief Minimum corner of the bounding box of the frustum.
+    public: const ignition::math::Vector3d &Min() const;
+
+    /// \brief Maximum corner of the bounding box of the frustum.
+    public: const ignition::math::Vector3d &Max() const;
+
+    /// \brief Normals of the planes, pointing inwards. A point p is inside
+    /// if normal.Dot(p) + offset >= 0 for all the planes.
+    private: ignition::math::Vector3d normals[6];
+
+    /// \brief Offsets of the planes.
+    private: double offsets[6];
+
+    /// \brief Minimum corner of the bounding box of the frustum.
+    private: ignition::math::Vector3d boxMin;
+
+    /// \brief Maximum corner of the bounding box of the frustum.
+    private: ignition::math::Vector3d boxMax;
+  };
+
+  /// \brief Process-wide evaluation of the logical cameras.
+  ///
+  /// A logical camera sensor tests every model of the world against its
+  /// frustum. Once enabled by LogicalPerceptionPlugin, the engine keeps the
+  /// bounding boxes of the models in a uniform grid instead, updated at the
+  /// end of every step from the models that moved. Each registered camera
+  /// whose period elapsed is then evaluated against the grid cells covered
+  /// by its frustum only, and its listener gets the same image a logical
+  /// camera sensor would have published. Listeners are called from the
+  /// physics thread and must not register or unregister from within the
+  /// callback.
+  class GAZEBO_VISIBLE LogicalPerceptionEngine
+  {
+    /// \brief Callback receiving the images of a camera.
+    public: using Listener =
+      std::function<void(ConstLogicalCameraImagePtr &, const common::Time &)>;
+
+    /// \brief Get the engine shared by all the plugins.
+    public: static LogicalPerceptionEngine &Instance();
+
+    /// \brief Start evaluating the logical cameras of a world.
+    /// \param[in] _world World to read the models from.
+    /// \param[in] _cellSize Size of the cells of the grid, in meters.
+    public: void Enable(const physics::WorldPtr &_world, double _cellSize);
+
+    /// \brief Whether the engine was enabled. Plugins that find it disabled
+    /// keep using their logical camera sensor.
+    public: bool Enabled();
+
+    /// \brief Register a camera. It is inactive until SetActive() is called.
+    /// \param[in] _params Frustum and rate of the camera.
+    /// \param[in] _listener Callback receiving the images.
+    /// \returns Id to pass to SetActive() and Unregister().
+    public: unsigned int Register(const LogicalCameraParams &_params,
+                                  const Listener &_listener);
+
+    /// \brief Start or stop evaluating a camera.
+    /// \param[in] _id Id returned when the camera was registered.
+    /// \param[in] _active True to evaluate the camera.
+    public: void SetActive(unsigned int _id, bool _active);
+
+    /// \brief Remove a camera.
+    /// \param[in] _id Id returned when the camera was registered.
+    public: void Unregister(unsigned int _id);
+
+    /// \brief Grid cells covered by a box, inclusive.
+    /// \param[in] _min Minimum corner of the box.
+    /// \param[in] _max Maximum corner of the box.
+    /// \param[in] _cellSize Size of the cells.
+    /// \param[out] _cellMin Indices of the first cell along each axis.
+    /// \param[out] _cellMax Indices of the last cell along each axis.
+    public: static void CellRange(const ignition::math::Vector3d &_min,
+                                  const ignition::math::Vector3d &_max,
+                                  double _cellSize, int _cellMin[3], int _cellMax[3]);
+
+    /// \brief Constructor. Use Instance().
+    private: LogicalPerceptionEngine() = default;
+
+    /// \brief Update the grid and evaluate the cameras.
+    private: void OnWorldUpdateEnd();
+
+    /// \brief Add the models inserted since the last step and drop the
+    /// deleted ones. Expects the mutex to be locked.
+    private: void SyncModels();
+
+    /// \brief Refresh the bounding box of a model if it or any of its links
+    /// moved and move it to the cells it now covers. Expects the mutex to be
+    /// locked.
+    /// \param[in] _slot Slot of the model.
+    /// \param[in] _force Refresh even if the model didn't move.
+    /// \returns False if the model no longer exists.
+    private: bool UpdateModel(size_t _slot, bool _force);
+
+    /// \brief Add or remove a model from the cells of its cell range.
+    /// Expects the mutex to be locked.
+    /// \param[in] _slot Slot of the model.
+    /// \param[in] _insert True to add the model, false to remove it.
+    private: void BinModel(size_t _slot, bool _insert);
+
+    /// \brief Start tracking a model. Expects the mutex to be locked.
+    /// \param[in] _model The model.
+    /// \returns Slot of the model.
+    private: size_t AddModel(const physics::ModelPtr &_model);
+
+    /// \brief Release the slot of a model. Expects the mutex to be locked.
+    /// \param[in] _slot Slot of the model.
+    private: void RemoveModel(size_t _slot);
+
+    /// \brief Key of the grid cell with the given indices.
+    private: static int64_t CellKey(int _x, int _y, int _z);
+
+    /// \brief A registered camera.
+    private: struct CameraEntry
+    {
+      /// \brief Frustum and rate.
+      LogicalCameraParams params;
+
+      /// \brief Callback.
+      Listener callback;
+
+      /// \brief Whether the camera is evaluated.
+      bool active = false;
+
+      /// \brief Simulation time of the last image.
+      common::Time lastImageTime;
+
+      /// \brief Image handed over to the callback, reused from one image to
+      /// the next.
+      boost::shared_ptr<msgs::LogicalCameraImage> image;
+    };
+
+    /// \brief A model tracked by the grid. Its bounding box is stored in the
+    /// box arrays, at the same slot.
+    private: struct ModelEntry
+    {
+      /// \brief The model, expired if the slot is free.
+      boost::weak_ptr<physics::Model> model;
+
+      /// \brief Scoped name of the model.
+      std::string name;
+
+      /// \brief Pose of the model when its bounding box was computed.
+      ignition::math::Pose3d pose;
+
+      /// \brief Poses of the links of the model when its bounding box was
+      /// computed. The links of articulated models, such as the robots, move
+      /// while the model pose doesn't.
+      std::vector<ignition::math::Pose3d> linkPoses;
+
+      /// \brief Whether the model is static; static models are never
+      /// refreshed.
+      bool isStatic = false;
+
+      /// \brief Whether the model covers too many cells for the grid and is
+      /// tested by every camera.
+      bool large = false;
+
+      /// \brief Cell range covered by the bounding box, inclusive.
+      int cellMin[3] = {0, 0, 0};
+
+      /// \brief Cell range covered by the bounding box, inclusive.
+      int cellMax[3] = {0, 0, 0};
+
+      /// \brief Last query that gathered the model, to gather it once.
+      uint32_t queryStamp = 0;
+
+      /// \brief Last synchronization that found the model in the world.
+      uint32_t syncStamp = 0;
+    };
+
+    /// \brief Evaluate a camera. Expects the mutex to be locked.
+    /// \param[in] _camera The camera.
+    /// \param[in] _time Simulation time of the image.
+    private: void EvaluateCamera(CameraEntry &_camera, const common::Time &_time);
+
+    /// \brief World the models are read from.
+    private: physics::WorldPtr world;
+
+    /// \brief Size of the cells of the grid.
+    private: double cellSize = 0.5;
+
+    /// \brief Cameras by id.
+    private: std::unordered_map<unsigned int, CameraEntry> cameras;
+
+    /// \brief Id of the next camera.
+    private: unsigned int nextId = 1;
+
+    /// \brief Tracked models, by slot.
+    private: std::vector<ModelEntry> models;
+
+    /// \brief Bounding boxes of the tracked models, by slot, one array per
+    /// coordinate so that the frustum tests vectorize.
+    private: std::vector<double> boxMin[3];
+
+    /// \brief Bounding boxes of the tracked models, by slot.
+    private: std::vector<double> boxMax[3];
+
+    /// \brief Free slots.
+    private: std::vector<size_t> freeSlots;
+
+    /// \brief Slots of the tracked models, by scoped name.
+    private: std::unordered_map<std::string, size_t> slotsByName;
+
+    /// \brief Slots of the non static models.
+    private: std::vector<size_t> dynamicSlots;
+
+    /// \brief Slots of the large models.
+    private: std::vector<size_t> largeSlots;
+
+    /// \brief Slots of the models covering each cell, by cell key.
+    private: std::unordered_map<int64_t, std::vector<size_t>> cells;
+
+    /// \brief Stamp of the current query.
+    private: uint32_t queryStamp = 0;
+
+    /// \brief Stamp of the current synchronization with the world.
+    private: uint32_t syncStamp = 0;
+
+    /// \brief Slots gathered by the current query.
+    private: std::vector<size_t> candidates;
+
+    /// \brief Bounding boxes of the candidates, one array per coordinate.
+    private: std::vector<double> candidateMin[3];
+
+    /// \brief Bounding boxes of the candidates, one array per coordinate.
+    private: std::vector<double> candidateMax[3];
+
+    /// \brief Whether each candidate is outside the frustum.
+    private: std::vector<uint8_t> outside;
+
+    /// \brief Protects everything above.
+    private: std::mutex mutex;
+
+    /// \brief Set when a model is inserted or deleted.
+    private: std::atomic<bool> modelsChanged{true};
+
+    /// \brief Connection to the end of the world update.
+    private: event::ConnectionPtr updateConnection;
+
+    /// \brief Connection to the entity insertion event.
+    private: event::ConnectionPtr addEntityConnection;
+
+    /// \brief Connection to the entity deletion event.
+    private: event::ConnectionPtr deleteEntityConnection;
+  };
+}
+#endif
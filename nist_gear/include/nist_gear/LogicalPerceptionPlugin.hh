@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GAZEBO_LOGICAL_PERCEPTION_PLUGIN_HH_
+#define GAZEBO_LOGICAL_PERCEPTION_PLUGIN_HH_
+
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+#include <sdf/sdf.hh>
+
+namespace gazebo
+{
+  /// \brief A plugin that enables the LogicalPerceptionEngine for the world.
+  ///
+  /// The size of the cells of the grid can be set with <cell_size> (0.5 m by
+  /// default). When the engine is enabled, ROSLogicalCameraPlugin leaves its
+  /// logical camera sensor asleep and gets its images from the engine.
+  class GAZEBO_VISIBLE LogicalPerceptionPlugin : public WorldPlugin
+  {
+    /// \brief Constructor.
+  public:
+    LogicalPerceptionPlugin();
+
+    /// \brief Destructor.
+  public:
+    virtual ~LogicalPerceptionPlugin();
+
+    // Documentation inherited.
+  public:
+    virtual void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+  };
+} // namespace gazebo
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _GAZEBO_MODEL_POOL_HH_
+#define _GAZEBO_MODEL_POOL_HH_
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/weak_ptr.hpp>
+#include <gazebo/common/Events.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+#include <ignition/math/Pose3.hh>
+
+namespace gazebo
+{
+  /// \brief Process-wide pool of the product models that were removed from
+  /// the workcell (cleared trays, disposed products).
+  ///
+  /// A released model is parked in its own slot below the floor, with its
+  /// links disabled, without gravity and without collisions, so it costs
+  /// nothing to the physics engine. Slots are reused once their model is
+  /// acquired again, so the parking area doesn't grow in long runs.
+  /// Acquire() hands a parked model of the requested type back, ready to be
+  /// placed in the world. The pool is safe to use from any thread.
+  class GAZEBO_VISIBLE ModelPool
+  {
+    /// \brief Get the pool shared by all the plugins.
+    public: static ModelPool &Instance();
+
+    /// \brief Park a model in the pool. Does nothing if it's already parked.
+    /// \param[in] _model Model to park.
+    public: void Release(const physics::ModelPtr &_model);
+
+    /// \brief Take a parked model of a given type out of the pool.
+    /// The model is re-enabled but stays at its parking pose.
+    /// \param[in] _type Product type (e.g. disk_part_blue).
+    /// \returns The model, or null if no model of that type is parked.
+    public: physics::ModelPtr Acquire(const std::string &_type);
+
+    /// \brief Take a specific model out of the pool if it's parked.
+    /// \param[in] _model Model to take out.
+    /// \returns True if the model was parked.
+    public: bool Reclaim(const physics::ModelPtr &_model);
+
+    /// \brief Whether a model is parked in the pool.
+    /// \param[in] _name Scoped name of the model.
+    public: bool IsParked(const std::string &_name);
+
+    /// \brief Number of models parked in the pool.
+    public: size_t Size();
+
+    /// \brief Constructor. Use Instance().
+    private: ModelPool();
+
+    /// \brief Drop a model that was deleted from the world.
+    /// \param[in] _name Scoped name of the deleted entity.
+    private: void OnDeleteEntity(const std::string &_name);
+
+    /// \brief Re-enable a model and free its slot. Expects the mutex to be locked.
+    /// \param[in] _name Scoped name of the parked model.
+    /// \returns The model, or null if it no longer exists.
+    private: physics::ModelPtr Unpark(const std::string &_name);
+
+    /// \brief Parking pose of a slot.
+    private: static ignition::math::Pose3d SlotPose(unsigned int _slot);
+
+    /// \brief A parked model.
+    private: struct ParkedModel
+    {
+      /// \brief The model.
+      boost::weak_ptr<physics::Model> model;
+
+      /// \brief Product type of the model.
+      std::string type;
+
+      /// \brief Parking slot of the model.
+      unsigned int slot;
+    };
+
+    /// \brief Parked models by scoped name.
+    private: std::unordered_map<std::string, ParkedModel> parked;
+
+    /// \brief Names of the parked models by type, in release order.
+    private: std::unordered_map<std::string, std::deque<std::string>> available;
+
+    /// \brief Slots released by acquired models.
+    private: std::vector<unsigned int> freeSlots;
+
+    /// \brief Number of slots ever used.
+    private: unsigned int slotCount = 0;
+
+    /// \brief Protects the pool.
+    private: std::mutex mutex;
+
+    /// \brief Connection to the entity deletion event.
+    private: event::ConnectionPtr deleteEntityConnection;
+  };
+}
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GAZEBO_ROS_AGV_DISPATCHER_PLUGIN_HH_
+#define GAZEBO_ROS_AGV_DISPATCHER_PLUGIN_HH_
+
+#include <memory>
+#include <string>
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+#include <nist_gear/AGVDispatch.h>
+#include <nist_gear/AGVTelemetry.h>
+#include <sdf/sdf.hh>
+#include <std_msgs/String.h>
+
+namespace gazebo
+{
+  // Forward declare private data class
+  class ROSAGVDispatcherPluginPrivate;
+
+  /// \brief A plugin that coordinates the moves of all the AGVs in the world.
+  ///
+  /// Move requests are received on a single ROS service (<dispatch_service_name>,
+  /// "agv_dispatch" by default). Each AGV drives on a lane made of the nodes
+  /// KS -> AS1/AS4 -> AS2/AS5 -> AS3/AS6. A move reserves the lane segments
+  /// between its origin and its destination, the destination station and the
+  /// AGV itself. Moves whose reservations are free are started right away by
+  /// publishing the destination on the AGV's dispatch topic (see the
+  /// <dispatch_topic> element of ROSAGVPlugin). Conflicting moves are queued in
+  /// FIFO order and the service response reports the estimated arrival time.
+  ///
+  /// By default agv1..agv4 are managed, each one on its own lane. AGVs sharing
+  /// a lane can be described with:
+  ///
+  ///  <agv>
+  ///    <name>agv1</name>
+  ///    <lane>lane_north</lane>
+  ///  </agv>
+  ///
+  /// A reservation is released when the AGV reports its arrival on
+  /// /ariac/<agv>/telemetry or "ready_to_deliver" again on /ariac/<agv>/state,
+  /// or after <move_timeout> seconds past the expected arrival time.
+  class GAZEBO_VISIBLE ROSAGVDispatcherPlugin : public WorldPlugin
+  {
+    /// \brief Constructor.
+  public:
+    ROSAGVDispatcherPlugin();
+
+    /// \brief Destructor.
+  public:
+    virtual ~ROSAGVDispatcherPlugin();
+
+    // Documentation inherited.
+  public:
+    virtual void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+
+    /// \brief Update the plugin.
+  protected:
+    void OnUpdate();
+
+    /// \brief Callback for a move request.
+  public:
+    bool HandleDispatchService(
+        nist_gear::AGVDispatch::Request &_req, nist_gear::AGVDispatch::Response &_res);
+
+    /// \brief Callback receiving the state of an AGV.
+    /// \param[in] _msg State published by ROSAGVPlugin.
+    /// \param[in] _agvName Name of the AGV publishing the state.
+  protected:
+    void OnAGVState(const std_msgs::String::ConstPtr &_msg, const std::string &_agvName);
+
+    /// \brief Callback receiving the telemetry of an AGV, used to refine the
+    /// arrival time of its move and to detect its arrival.
+    /// \param[in] _msg Telemetry published by ROSAGVPlugin.
+  protected:
+    void OnAGVTelemetry(const nist_gear::AGVTelemetry::ConstPtr &_msg);
+
+    /// \brief Start the queued moves whose reservations are free and release
+    /// the moves that are done. Expects the mutex to be locked.
+  protected:
+    void ProcessMoves();
+
+    /// \brief Private data pointer.
+  private:
+    std::unique_ptr<ROSAGVDispatcherPluginPrivate> dataPtr;
+  };
+} // namespace gazebo
+#endif
@@ -19,6 +19,8 @@
 #define GAZEBO_ROS_ARIAC_TASK_MANAGER_PLUGIN_HH_
 
 #include <memory>
+#include <string>
+#include <vector>
 #include <gazebo/common/Plugin.hh>
 #include <gazebo/physics/PhysicsTypes.hh>
 #include <nist_gear/AGVControl.h>
@@ -35,6 +37,9 @@ namespace gazebo
   // Forward declare private data class
   class ROSAriacTaskManagerPluginPrivate;
 
+  // Forward declare the contacts handed over by the ContactDispatcher
+  struct ContactRecord;
+
   /// \brief A plugin that orchestrates an ARIAC task. First of all, it loads a
   /// description of the orders. Here's an example:
   ///
@@ -183,6 +188,19 @@ namespace gazebo
   protected:
     void OnContactsReceived(ConstContactsPtr &_msg);
 
+    /// \brief Callback that receives all the contacts of the world from the
+    /// ContactDispatcher.
+  protected:
+    void OnContactRecords(const std::vector<ContactRecord> &_records);
+
+    /// \brief Notify the scorer if a contact is between two links of the robot.
+    /// \param[in] _collision1 Scoped name of the first collision.
+    /// \param[in] _collision2 Scoped name of the second collision.
+    /// \param[in] _time Simulation time of the contact.
+  protected:
+    void CheckArmArmContact(const std::string &_collision1, const std::string &_collision2,
+                            const common::Time &_time);
+
     /// \brief Announce an order to participants.
   protected:
     void AnnounceOrder(const ariac::Order &order);
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GAZEBO_ROS_LOGICAL_CAMERA_AGGREGATOR_PLUGIN_HH_
+#define GAZEBO_ROS_LOGICAL_CAMERA_AGGREGATOR_PLUGIN_HH_
+
+#include <memory>
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+#include <sdf/sdf.hh>
+
+namespace gazebo
+{
+  // Forward declare private data class
+  class ROSLogicalCameraAggregatorPluginPrivate;
+
+  /// \brief A plugin that publishes the models seen by all the logical
+  /// cameras, in the world frame and de-duplicated by name.
+  ///
+  /// The fused detections are published on <topic> ("logical_cameras/fused"
+  /// by default, relative to <robot_namespace>) at <update_rate> (10 Hz by
+  /// default) as nist_gear/FusedLogicalCameraImage messages. Detections older
+  /// than <max_age> seconds (0.5 by default) are dropped. The poses carry
+  /// the noise of the cameras, and the cameras in blackout don't contribute.
+  /// Cameras with anonymized models (the quality control sensors) are left
+  /// out unless their <aggregate> element is true. The cameras are only kept
+  /// awake for the aggregator while the topic has subscribers.
+  class GAZEBO_VISIBLE ROSLogicalCameraAggregatorPlugin : public WorldPlugin
+  {
+    /// \brief Constructor.
+  public:
+    ROSLogicalCameraAggregatorPlugin();
+
+    /// \brief Destructor.
+  public:
+    virtual ~ROSLogicalCameraAggregatorPlugin();
+
+    // Documentation inherited.
+  public:
+    virtual void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+
+    /// \brief Publish the fused detections if the period elapsed.
+  protected:
+    void OnUpdate();
+
+    /// \brief Called when the topic gets a subscriber.
+  protected:
+    void OnConnect();
+
+    /// \brief Called when the topic loses a subscriber.
+  protected:
+    void OnDisconnect();
+
+    /// \brief Private data pointer.
+  private:
+    std::unique_ptr<ROSLogicalCameraAggregatorPluginPrivate> dataPtr;
+  };
+} // namespace gazebo
+#endif
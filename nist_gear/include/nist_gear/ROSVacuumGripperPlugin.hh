@@ -21,6 +21,7 @@
 #include <memory>
 #include <gazebo/physics/PhysicsTypes.hh>
 #include <sdf/sdf.hh>
+#include <std_msgs/String.h>
 #include "nist_gear/VacuumGripperControl.h"
 #include "nist_gear/VacuumGripperPlugin.hh"
 
@@ -51,9 +52,20 @@ namespace gazebo
       nist_gear::VacuumGripperControl::Request &_req,
       nist_gear::VacuumGripperControl::Response &_res);
 
+    /// \brief Receives the competition state, to dump the grasp statistics
+    /// at the end of the trial.
+    /// \param[in] _msg The competition state.
+    public: void OnCompetitionState(const std_msgs::String::ConstPtr &_msg);
+
     // Documentation inherited.
     private: virtual void Publish() const;
 
+    // Documentation inherited.
+    private: virtual void PublishStats() const;
+
+    /// \brief Print the grasp statistics once.
+    private: void DumpStats();
+
     /// \internal
     /// \brief Pointer to private data.
     private: std::unique_ptr<ROSVacuumGripperPluginPrivate> dataPtr;
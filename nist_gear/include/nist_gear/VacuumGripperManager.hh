@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _GAZEBO_VACUUM_GRIPPER_MANAGER_HH_
+#define _GAZEBO_VACUUM_GRIPPER_MANAGER_HH_
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <gazebo/common/Events.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+
+#include "nist_gear/ContactDispatcher.hh"
+
+namespace gazebo
+{
+  /// \brief Process-wide owner of the contacts and updates of the vacuum
+  /// grippers.
+  ///
+  /// Once enabled by VacuumGripperManagerPlugin, the grippers register their
+  /// suction cup collisions here instead of creating their own contact
+  /// manager filter and world update connection. The manager watches the
+  /// collisions of all the grippers at once: it registers a single
+  /// ContactDispatcher listener if the dispatcher is enabled, and otherwise
+  /// reads the contacts of the contact manager itself. At the end of every
+  /// step, the contacts are split by suction cup collision and each gripper
+  /// gets its contacts and is updated, in one pass and from the physics
+  /// thread. Callbacks must not register or unregister grippers.
+  class GAZEBO_VISIBLE VacuumGripperManager
+  {
+    /// \brief Callback receiving the contacts of a gripper. The records are
+    /// oriented with the suction cup collision first.
+    public: using ContactsCallback = std::function<void(const std::vector<ContactRecord> &)>;
+
+    /// \brief Callback updating a gripper once its contacts were handed over.
+    public: using UpdateCallback = std::function<void()>;
+
+    /// \brief Get the manager shared by all the grippers.
+    public: static VacuumGripperManager &Instance();
+
+    /// \brief Start managing the grippers of a world.
+    /// \param[in] _world World the grippers live in.
+    public: void Enable(const physics::WorldPtr &_world);
+
+    /// \brief Whether the manager was enabled. Grippers that find it
+    /// disabled keep their own contact filter and update connection.
+    public: bool Enabled();
+
+    /// \brief Register a gripper.
+    /// \param[in] _collisions Collisions of the suction cup.
+    /// \param[in] _onContacts Callback receiving the contacts of the step.
+    /// \param[in] _onUpdate Callback updating the gripper.
+    /// \returns Id to pass to Unregister().
+    public: unsigned int Register(const std::vector<physics::CollisionPtr> &_collisions,
+                                  const ContactsCallback &_onContacts,
+                                  const UpdateCallback &_onUpdate);
+
+    /// \brief Remove a gripper.
+    /// \param[in] _id Id returned when the gripper was registered.
+    public: void Unregister(unsigned int _id);
+
+    /// \brief Constructor. Use Instance().
+    private: VacuumGripperManager() = default;
+
+    /// \brief Update the grippers with contacts read from the contact manager.
+    private: void OnWorldUpdateEnd();
+
+    /// \brief Update the grippers with the contacts of the ContactDispatcher.
+    /// \param[in] _records Contacts of the suction cup collisions.
+    private: void OnContactRecords(const std::vector<ContactRecord> &_records);
+
+    /// \brief Hand the contacts over to the grippers and update them.
+    /// Expects the mutex to be locked and the batches to be filled.
+    private: void UpdateGrippers();
+
+    /// \brief Register the suction cup collisions of all the grippers with
+    /// the ContactDispatcher, in place of the previous listener. Expects the
+    /// registration mutex to be locked, and the mutex not to be, as the
+    /// dispatcher calls OnContactRecords() with its own mutex locked.
+    private: void RegisterWithDispatcher();
+
+    /// \brief A registered gripper.
+    private: struct GripperEntry
+    {
+      /// \brief Contacts callback.
+      ContactsCallback onContacts;
+
+      /// \brief Update callback.
+      UpdateCallback onUpdate;
+
+      /// \brief The suction cup collisions.
+      std::vector<physics::CollisionPtr> collisions;
+
+      /// \brief Contacts of the current step.
+      std::vector<ContactRecord> batch;
+    };
+
+    /// \brief World the grippers live in.
+    private: physics::WorldPtr world;
+
+    /// \brief Grippers by id.
+    private: std::unordered_map<unsigned int, GripperEntry> grippers;
+
+    /// \brief Id of the gripper owning each suction cup collision, by
+    /// collision id.
+    private: std::unordered_map<uint32_t, unsigned int> byCollision;
+
+    /// \brief Whether the contacts come from the ContactDispatcher.
+    private: bool useDispatcher = false;
+
+    /// \brief Id of the ContactDispatcher listener, 0 if none.
+    private: unsigned int dispatcherListenerId = 0;
+
+    /// \brief Id of the next gripper.
+    private: unsigned int nextId = 1;
+
+    /// \brief Protects the grippers.
+    private: std::mutex mutex;
+
+    /// \brief Serializes the registrations.
+    private: std::mutex registrationMutex;
+
+    /// \brief Connection to the end of the world update.
+    private: event::ConnectionPtr updateConnection;
+  };
+}
+#endif
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GAZEBO_VACUUM_GRIPPER_MANAGER_PLUGIN_HH_
+#define GAZEBO_VACUUM_GRIPPER_MANAGER_PLUGIN_HH_
+
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/physics/PhysicsTypes.hh>
+#include <sdf/sdf.hh>
+
+namespace gazebo
+{
+  /// \brief A plugin that enables the VacuumGripperManager for the world.
+  ///
+  /// It must be listed after contact_dispatcher, if any, so that the
+  /// grippers share its contacts. Model plugins are always loaded after it.
+  /// Without this plugin, every VacuumGripperPlugin creates its own contact
+  /// filter and world update connection as before.
+  class GAZEBO_VISIBLE VacuumGripperManagerPlugin : public WorldPlugin
+  {
+    /// \brief Constructor.
+  public:
+    VacuumGripperManagerPlugin();
+
+    /// \brief Destructor.
+  public:
+    virtual ~VacuumGripperManagerPlugin();
+
+    // Documentation inherited.
+  public:
+    virtual void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+  };
+} // namespace gazebo
+#endif
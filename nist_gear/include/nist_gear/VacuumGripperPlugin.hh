@@ -18,10 +18,14 @@
 #ifndef _GAZEBO_VACUUM_GRIPPER_PLUGIN_HH_
 #define _GAZEBO_VACUUM_GRIPPER_PLUGIN_HH_
 
+#include <cstdint>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <vector>
 #include <gazebo/common/Events.hh>
 #include <gazebo/common/Plugin.hh>
+#include <gazebo/common/Time.hh>
 #include <gazebo/msgs/contacts.pb.h>
 #include <gazebo/physics/PhysicsTypes.hh>
 #include <sdf/sdf.hh>
@@ -31,6 +35,44 @@ namespace gazebo
   /// \brief Forward declaration of the private data class.
   class VacuumGripperPluginPrivate;
 
+  /// \brief Forward declaration of the contacts handed over by the
+  /// ContactDispatcher.
+  struct ContactRecord;
+
+  /// \brief Timings of a grasp, in simulation time. Times that weren't
+  /// reached are zero.
+  struct VacuumGripperGrasp
+  {
+    /// \brief The suction was enabled.
+    common::Time enableTime;
+
+    /// \brief The gripper first had at least min_contact_count contacts.
+    common::Time firstContactTime;
+
+    /// \brief The object was attached (posCount crossed attach_steps).
+    common::Time attachTime;
+
+    /// \brief The object was detached.
+    common::Time detachTime;
+  };
+
+  /// \brief Statistics of the grasp pipeline of a gripper.
+  struct VacuumGripperStats
+  {
+    /// \brief Completed grasps, in order.
+    std::vector<VacuumGripperGrasp> grasps;
+
+    /// \brief Updates skipped because of the gripper's update rate.
+    uint64_t gatedUpdates = 0;
+
+    /// \brief Updates in which the contacts were evaluated.
+    uint64_t evaluatedUpdates = 0;
+
+    /// \brief contactHistogram[i] is the number of evaluated updates with
+    /// i contacts. The last bin also counts the updates with more contacts.
+    std::vector<uint32_t> contactHistogram;
+  };
+
   /// \brief
   class GAZEBO_VISIBLE VacuumGripperPlugin : public ModelPlugin
   {
@@ -57,6 +99,22 @@ namespace gazebo
     /// created between the gripper and another model.
     public: bool Attached() const;
 
+    /// \brief Simulation time of the last attach of an object.
+    /// \return The time, or zero if nothing was attached yet.
+    public: common::Time LastAttachTime() const;
+
+    /// \brief Simulation time of the last detach of an object.
+    /// \return The time, or zero if nothing was detached yet.
+    public: common::Time LastDetachTime() const;
+
+    /// \brief Get the statistics of the grasp pipeline.
+    /// \return A copy of the statistics.
+    public: VacuumGripperStats Stats() const;
+
+    /// \brief Print the statistics of the grasp pipeline, one grasp per line.
+    /// \param[out] _out Stream to print to.
+    public: void PrintStats(std::ostream &_out) const;
+
     /// \brief Enable the suction.
     public: void Enable();
 
@@ -70,6 +128,11 @@ namespace gazebo
     /// \param[in] _msg Message that contains contact information.
     private: void OnContacts(ConstContactsPtr &_msg);
 
+    /// \brief Callback receiving the contacts of the suction cup from the
+    /// ContactDispatcher or the VacuumGripperManager.
+    /// \param[in] _records Contacts of the suction cup collisions.
+    private: void OnContactRecords(const std::vector<ContactRecord> &_records);
+
     /// \brief Determine if the colliding model is sufficiently in contact with the gripper.
     /// \return True if the colliding model is sufficiently in contact with the gripper.
     private: bool CheckModelContact();
@@ -84,10 +147,18 @@ namespace gazebo
     /// \brief Detach an object from the gripper.
     private: void HandleDetach();
 
-    /// \brief Overwrite this method for sending periodic updates with the
-    /// gripper state.
+    /// \brief Call Publish() if the gripper was enabled, disabled, attached
+    /// or detached since the last call, or if the keepalive period elapsed.
+    private: void PublishIfNeeded();
+
+    /// \brief Overwrite this method for sending updates with the gripper
+    /// state. Called on every state change and at <state_keepalive_rate>.
     private: virtual void Publish() const;
 
+    /// \brief Overwrite this method for sending the grasp statistics.
+    /// Called after every attach and detach.
+    private: virtual void PublishStats() const;
+
     /// \internal
     /// \brief Pointer to private data.
     private: std::unique_ptr<VacuumGripperPluginPrivate> dataPtr;
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <gazebo/common/Console.hh>
+#include <gazebo/physics/Collision.hh>
+#include <gazebo/physics/Contact.hh>
+#include <gazebo/physics/ContactManager.hh>
+#include <gazebo/physics/PhysicsEngine.hh>
+#include <gazebo/physics/World.hh>
+
+#include "nist_gear/ContactDispatcher.hh"
+
+using namespace gazebo;
+
+/////////////////////////////////////////////////
+static physics::CollisionPtr SharedCollision(physics::Collision *_collision)
+{
+  if (!_collision)
+    return nullptr;
+  return boost::static_pointer_cast<physics::Collision>(_collision->shared_from_this());
+}
+
+/////////////////////////////////////////////////
+ContactDispatcher &ContactDispatcher::Instance()
+{
+  static ContactDispatcher instance;
+  return instance;
+}
+
+/////////////////////////////////////////////////
+void ContactDispatcher::Enable(const physics::WorldPtr &_world)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (this->world)
+  {
+    gzwarn << "ContactDispatcher already enabled" << std::endl;
+    return;
+  }
+  this->world = _world;
+
+  // Contacts are normally only kept when a filter or the contact topic has
+  // subscribers. The listeners don't go through either of them.
+  this->world->Physics()->GetContactManager()->SetNeverDropContacts(true);
+
+  this->updateConnection = event::Events::ConnectWorldUpdateEnd(
+    std::bind(&ContactDispatcher::OnWorldUpdateEnd, this));
+}
+
+/////////////////////////////////////////////////
+bool ContactDispatcher::Enabled()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->world != nullptr;
+}
+
+/////////////////////////////////////////////////
+unsigned int ContactDispatcher::Register(
+  const std::vector<physics::CollisionPtr> &_collisions, const Listener &_listener)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  unsigned int id = this->nextId++;
+  ListenerEntry &entry = this->listeners[id];
+  entry.callback = _listener;
+  for (const auto &collision : _collisions)
+  {
+    if (!collision)
+      continue;
+    entry.collisionIds.push_back(collision->GetId());
+    this->byCollision[collision->GetId()].push_back(id);
+  }
+  return id;
+}
+
+/////////////////////////////////////////////////
+unsigned int ContactDispatcher::RegisterAll(const Listener &_listener)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  unsigned int id = this->nextId++;
+  this->listeners[id].callback = _listener;
+  this->catchAll.push_back(id);
+  return id;
+}
+
+/////////////////////////////////////////////////
+void ContactDispatcher::Unregister(unsigned int _id)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->listeners.find(_id);
+  if (it == this->listeners.end())
+    return;
+
+  for (auto collisionId : it->second.collisionIds)
+  {
+    auto &ids = this->byCollision[collisionId];
+    ids.erase(std::remove(ids.begin(), ids.end(), _id), ids.end());
+    if (ids.empty())
+      this->byCollision.erase(collisionId);
+  }
+  this->catchAll.erase(
+    std::remove(this->catchAll.begin(), this->catchAll.end(), _id), this->catchAll.end());
+  this->listeners.erase(it);
+}
+
+/////////////////////////////////////////////////
+void ContactDispatcher::OnWorldUpdateEnd()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (this->listeners.empty())
+    return;
+
+  auto mgr = this->world->Physics()->GetContactManager();
+  const auto &contacts = mgr->GetContacts();
+  unsigned int contactCount = std::min<size_t>(mgr->GetContactCount(), contacts.size());
+
+  for (auto &entry : this->listeners)
+    entry.second.batch.clear();
+
+  for (unsigned int i = 0; i < contactCount; ++i)
+  {
+    const physics::Contact *contact = contacts[i];
+    if (!contact || !contact->collision1 || !contact->collision2)
+      continue;
+
+    auto watchers1 = this->byCollision.find(contact->collision1->GetId());
+    auto watchers2 = this->byCollision.find(contact->collision2->GetId());
+    if (watchers1 == this->byCollision.end() && watchers2 == this->byCollision.end() &&
+        this->catchAll.empty())
+    {
+      continue;
+    }
+
+    // Resolve the collision pointers once for all the listeners
+    ContactRecord record;
+    record.collision = SharedCollision(contact->collision1);
+    record.other = SharedCollision(contact->collision2);
+    record.normal = contact->count > 0 ? contact->normals[0] : ignition::math::Vector3d::Zero;
+    record.count = contact->count;
+    record.time = contact->time;
+
+    for (auto id : this->catchAll)
+      this->listeners[id].batch.push_back(record);
+
+    if (watchers1 != this->byCollision.end())
+    {
+      for (auto id : watchers1->second)
+        this->listeners[id].batch.push_back(record);
+    }
+
+    if (watchers2 != this->byCollision.end())
+    {
+      // Seen from collision2, the frames are reversed
+      std::swap(record.collision, record.other);
+      record.normal = -record.normal;
+      for (auto id : watchers2->second)
+        this->listeners[id].batch.push_back(record);
+    }
+  }
+
+  for (auto &entry : this->listeners)
+    entry.second.callback(entry.second.batch);
+}
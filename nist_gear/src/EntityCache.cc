@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gazebo/physics/Collision.hh>
+#include <gazebo/physics/Entity.hh>
+#include <gazebo/physics/Link.hh>
+#include <gazebo/physics/Model.hh>
+#include <gazebo/physics/World.hh>
+
+#include "nist_gear/EntityCache.hh"
+
+using namespace gazebo;
+
+/////////////////////////////////////////////////
+EntityCache &EntityCache::Instance()
+{
+  static EntityCache instance;
+  return instance;
+}
+
+/////////////////////////////////////////////////
+EntityCache::EntityCache()
+{
+  this->addEntityConnection = event::Events::ConnectAddEntity(
+    std::bind(&EntityCache::Invalidate, this, std::placeholders::_1));
+  this->deleteEntityConnection = event::Events::ConnectDeleteEntity(
+    std::bind(&EntityCache::Invalidate, this, std::placeholders::_1));
+}
+
+/////////////////////////////////////////////////
+physics::EntityPtr EntityCache::EntityByName(const physics::WorldPtr &_world,
+                                             const std::string &_name)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->entities.find(_name);
+    if (it != this->entities.end())
+    {
+      physics::EntityPtr entity = it->second.lock();
+      if (entity)
+        return entity;
+      this->entities.erase(it);
+    }
+  }
+
+  // Walk the entity tree without holding the lock.
+  physics::EntityPtr entity = _world->EntityByName(_name);
+  if (entity)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entities[_name] = entity;
+  }
+  return entity;
+}
+
+/////////////////////////////////////////////////
+physics::ModelPtr EntityCache::ModelByName(const physics::WorldPtr &_world,
+                                           const std::string &_name)
+{
+  return boost::dynamic_pointer_cast<physics::Model>(this->EntityByName(_world, _name));
+}
+
+/////////////////////////////////////////////////
+physics::LinkPtr EntityCache::LinkByName(const physics::WorldPtr &_world,
+                                         const std::string &_name)
+{
+  return boost::dynamic_pointer_cast<physics::Link>(this->EntityByName(_world, _name));
+}
+
+/////////////////////////////////////////////////
+physics::CollisionPtr EntityCache::CollisionByName(const physics::WorldPtr &_world,
+                                                   const std::string &_name)
+{
+  return boost::dynamic_pointer_cast<physics::Collision>(this->EntityByName(_world, _name));
+}
+
+/////////////////////////////////////////////////
+void EntityCache::Invalidate(const std::string &_name)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  const std::string prefix = _name + "::";
+  for (auto it = this->entities.begin(); it != this->entities.end();)
+  {
+    if (it->first == _name || it->first.compare(0, prefix.size(), prefix) == 0)
+      it = this->entities.erase(it);
+    else
+      ++it;
+  }
+}
+
+/////////////////////////////////////////////////
+void EntityCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->entities.clear();
+}
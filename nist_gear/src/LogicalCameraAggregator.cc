@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+
+#include "nist_gear/LogicalCameraAggregator.hh"
+
+using namespace gazebo;
+
+/////////////////////////////////////////////////
+LogicalCameraAggregator &LogicalCameraAggregator::Instance()
+{
+  static LogicalCameraAggregator instance;
+  return instance;
+}
+
+/////////////////////////////////////////////////
+unsigned int LogicalCameraAggregator::Register(const std::string &_camera,
+                                               const ActivationCallback &_onActivation)
+{
+  std::lock_guard<std::mutex> activationLock(this->activationMutex);
+  unsigned int id;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    id = this->nextId++;
+    CameraEntry &entry = this->cameras[id];
+    entry.name = _camera;
+    entry.onActivation = _onActivation;
+  }
+
+  if (this->wanted && _onActivation)
+    _onActivation(true);
+  return id;
+}
+
+/////////////////////////////////////////////////
+void LogicalCameraAggregator::Unregister(unsigned int _id)
+{
+  std::lock_guard<std::mutex> activationLock(this->activationMutex);
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->cameras.erase(_id);
+}
+
+/////////////////////////////////////////////////
+bool LogicalCameraAggregator::Wanted() const
+{
+  return this->wanted;
+}
+
+/////////////////////////////////////////////////
+void LogicalCameraAggregator::SetWanted(bool _wanted)
+{
+  std::lock_guard<std::mutex> activationLock(this->activationMutex);
+  if (this->wanted == _wanted)
+    return;
+  this->wanted = _wanted;
+
+  std::vector<ActivationCallback> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto &camera : this->cameras)
+    {
+      if (!_wanted)
+        camera.second.detections.clear();
+      if (camera.second.onActivation)
+        callbacks.push_back(camera.second.onActivation);
+    }
+  }
+
+  // The cameras lock their own mutex; don't hold ours
+  for (const auto &callback : callbacks)
+    callback(_wanted);
+}
+
+/////////////////////////////////////////////////
+void LogicalCameraAggregator::Report(unsigned int _id, const common::Time &_time,
+                                     const std::vector<LogicalCameraDetection> &_detections)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->cameras.find(_id);
+  if (it == this->cameras.end())
+    return;
+  it->second.time = _time;
+  it->second.detections = _detections;
+}
+
+/////////////////////////////////////////////////
+void LogicalCameraAggregator::Clear(unsigned int _id)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->cameras.find(_id);
+  if (it != this->cameras.end())
+    it->second.detections.clear();
+}
+
+/////////////////////////////////////////////////
+void LogicalCameraAggregator::Fuse(const common::Time &_now, const common::Time &_maxAge,
+                                   std::vector<FusedDetection> &_fused)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->fusedIndex.clear();
+
+  // The entries of _fused are overwritten in place to reuse their buffers
+  size_t count = 0;
+  for (const auto &camera : this->cameras)
+  {
+    const CameraEntry &entry = camera.second;
+    if (_maxAge > common::Time::Zero && _now - entry.time > _maxAge)
+      continue;
+
+    for (const auto &detection : entry.detections)
+    {
+      auto index = this->fusedIndex.find(detection.name);
+      if (index == this->fusedIndex.end())
+      {
+        if (count == _fused.size())
+          _fused.emplace_back();
+        FusedDetection &fused = _fused[count];
+        fused.detection = detection;
+        fused.time = entry.time;
+        fused.cameras.assign(1, entry.name);
+        this->fusedIndex[detection.name] = count++;
+        continue;
+      }
+
+      FusedDetection &fused = _fused[index->second];
+      fused.cameras.push_back(entry.name);
+      if (entry.time > fused.time)
+      {
+        fused.detection = detection;
+        fused.time = entry.time;
+      }
+    }
+  }
+  _fused.resize(count);
+
+  std::sort(_fused.begin(), _fused.end(),
+    [](const FusedDetection &_a, const FusedDetection &_b)
+    {
+      return _a.detection.name < _b.detection.name;
+    });
+}
@@ -0,0 +1,509 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <boost/make_shared.hpp>
+#include <gazebo/common/Console.hh>
+#include <gazebo/msgs/msgs.hh>
+#include <gazebo/physics/Link.hh>
+#include <gazebo/physics/Model.hh>
+#include <gazebo/physics/World.hh>
+#include <ignition/math/Box.hh>
+
+#include "nist_gear/LogicalPerceptionEngine.hh"
+
+using namespace gazebo;
+
+/// \brief Models covering more cells are tested by every camera.
+static const double kMaxModelCells = 512;
+
+/////////////////////////////////////////////////
+LogicalCameraFrustum::LogicalCameraFrustum(const LogicalCameraParams &_params,
+                                           const ignition::math::Pose3d &_pose)
+  : boxMin(INFINITY, INFINITY, INFINITY), boxMax(-INFINITY, -INFINITY, -INFINITY)
+{
+  // Planes of the frustum in the camera frame, with their normal pointing
+  // inwards. The camera looks along +X.
+  double tanH = std::tan(_params.horizontalFov / 2.0);
+  double tanV = tanH / _params.aspectRatio;
+  const ignition::math::Vector3d normals[6] = {
+    {1, 0, 0}, {-1, 0, 0}, {tanH, -1, 0}, {tanH, 1, 0}, {tanV, 0, -1}, {tanV, 0, 1}};
+  const double offsets[6] = {-_params.nearClip, _params.farClip, 0, 0, 0, 0};
+  for (int plane = 0; plane < 6; ++plane)
+  {
+    this->normals[plane] = _pose.Rot().RotateVector(normals[plane]);
+    this->offsets[plane] = offsets[plane] - this->normals[plane].Dot(_pose.Pos());
+  }
+
+  for (double x : {_params.nearClip, _params.farClip})
+  {
+    for (double sy : {-1.0, 1.0})
+    {
+      for (double sz : {-1.0, 1.0})
+      {
+        auto corner = _pose.CoordPositionAdd(
+          ignition::math::Vector3d(x, sy * x * tanH, sz * x * tanV));
+        this->boxMin.Min(corner);
+        this->boxMax.Max(corner);
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+void LogicalCameraFrustum::FlagOutside(size_t _count, const double *const _min[3],
+                                       const double *const _max[3], uint8_t *_outside) const
+{
+  // A box is outside if its corner furthest along the normal of a plane is
+  // behind that plane. The loops run over contiguous arrays and are
+  // vectorized by the compiler.
+  for (int plane = 0; plane < 6; ++plane)
+  {
+    const double nx = this->normals[plane].X();
+    const double ny = this->normals[plane].Y();
+    const double nz = this->normals[plane].Z();
+    const double offset = this->offsets[plane];
+    const double *px = nx >= 0 ? _max[0] : _min[0];
+    const double *py = ny >= 0 ? _max[1] : _min[1];
+    const double *pz = nz >= 0 ? _max[2] : _min[2];
+    for (size_t i = 0; i < _count; ++i)
+      _outside[i] |= (px[i] * nx + py[i] * ny + pz[i] * nz + offset) < 0.0;
+  }
+}
+
+/////////////////////////////////////////////////
+const ignition::math::Vector3d &LogicalCameraFrustum::Min() const
+{
+  return this->boxMin;
+}
+
+/////////////////////////////////////////////////
+const ignition::math::Vector3d &LogicalCameraFrustum::Max() const
+{
+  return this->boxMax;
+}
+
+/////////////////////////////////////////////////
+LogicalPerceptionEngine &LogicalPerceptionEngine::Instance()
+{
+  static LogicalPerceptionEngine instance;
+  return instance;
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::Enable(const physics::WorldPtr &_world, double _cellSize)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (this->world)
+  {
+    gzwarn << "LogicalPerceptionEngine already enabled" << std::endl;
+    return;
+  }
+  this->world = _world;
+  this->cellSize = _cellSize > 0 ? _cellSize : 0.5;
+
+  auto markModelsChanged = [this](std::string)
+  {
+    this->modelsChanged = true;
+  };
+  this->addEntityConnection = event::Events::ConnectAddEntity(markModelsChanged);
+  this->deleteEntityConnection = event::Events::ConnectDeleteEntity(markModelsChanged);
+  this->updateConnection = event::Events::ConnectWorldUpdateEnd(
+    std::bind(&LogicalPerceptionEngine::OnWorldUpdateEnd, this));
+}
+
+/////////////////////////////////////////////////
+bool LogicalPerceptionEngine::Enabled()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->world != nullptr;
+}
+
+/////////////////////////////////////////////////
+unsigned int LogicalPerceptionEngine::Register(const LogicalCameraParams &_params,
+                                               const Listener &_listener)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  unsigned int id = this->nextId++;
+  CameraEntry &camera = this->cameras[id];
+  camera.params = _params;
+  camera.callback = _listener;
+  camera.image = boost::make_shared<msgs::LogicalCameraImage>();
+  camera.image->set_near_clip(_params.nearClip);
+  camera.image->set_far_clip(_params.farClip);
+  camera.image->set_horizontal_fov(_params.horizontalFov);
+  camera.image->set_aspect_ratio(_params.aspectRatio);
+  return id;
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::SetActive(unsigned int _id, bool _active)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->cameras.find(_id);
+  if (it == this->cameras.end())
+    return;
+
+  // A camera that wakes up produces an image right away
+  if (_active && !it->second.active)
+    it->second.lastImageTime = common::Time::Zero;
+  it->second.active = _active;
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::Unregister(unsigned int _id)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->cameras.erase(_id);
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::CellRange(const ignition::math::Vector3d &_min,
+                                        const ignition::math::Vector3d &_max,
+                                        double _cellSize, int _cellMin[3], int _cellMax[3])
+{
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    _cellMin[axis] = static_cast<int>(std::floor(_min[axis] / _cellSize));
+    _cellMax[axis] = static_cast<int>(std::floor(_max[axis] / _cellSize));
+  }
+}
+
+/////////////////////////////////////////////////
+int64_t LogicalPerceptionEngine::CellKey(int _x, int _y, int _z)
+{
+  // 21 bits per axis, i.e. more than 500 km per axis with 0.25 m cells
+  return (static_cast<int64_t>(_x & 0x1FFFFF) << 42) |
+         (static_cast<int64_t>(_y & 0x1FFFFF) << 21) |
+         static_cast<int64_t>(_z & 0x1FFFFF);
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::OnWorldUpdateEnd()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  // The grid isn't maintained while no camera is evaluated. Moved models are
+  // refreshed when a camera wakes up, and static models never move.
+  bool anyActive = false;
+  for (const auto &camera : this->cameras)
+    anyActive |= camera.second.active;
+  if (!anyActive)
+    return;
+
+  if (this->modelsChanged.exchange(false))
+    this->SyncModels();
+
+  // Models destroyed before the deletion event was processed
+  std::vector<size_t> expired;
+  for (auto slot : this->dynamicSlots)
+  {
+    if (!this->UpdateModel(slot, false))
+      expired.push_back(slot);
+  }
+  for (auto slot : expired)
+    this->RemoveModel(slot);
+
+  common::Time now = this->world->SimTime();
+  for (auto &camera : this->cameras)
+  {
+    CameraEntry &entry = camera.second;
+    if (!entry.active)
+      continue;
+    if (entry.lastImageTime != common::Time::Zero &&
+        now - entry.lastImageTime < entry.params.period)
+    {
+      continue;
+    }
+    this->EvaluateCamera(entry, now);
+    entry.lastImageTime = now;
+  }
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::SyncModels()
+{
+  ++this->syncStamp;
+  for (const auto &model : this->world->Models())
+  {
+    auto it = this->slotsByName.find(model->GetScopedName());
+    if (it != this->slotsByName.end() && this->models[it->second].model.lock() != model)
+    {
+      // A model was deleted and another one inserted with the same name
+      this->RemoveModel(it->second);
+      it = this->slotsByName.end();
+    }
+    size_t slot = it != this->slotsByName.end() ? it->second : this->AddModel(model);
+    this->models[slot].syncStamp = this->syncStamp;
+  }
+
+  std::vector<size_t> deleted;
+  for (const auto &entry : this->slotsByName)
+  {
+    if (this->models[entry.second].syncStamp != this->syncStamp)
+      deleted.push_back(entry.second);
+  }
+  for (auto slot : deleted)
+    this->RemoveModel(slot);
+}
+
+/////////////////////////////////////////////////
+size_t LogicalPerceptionEngine::AddModel(const physics::ModelPtr &_model)
+{
+  size_t slot;
+  if (!this->freeSlots.empty())
+  {
+    slot = this->freeSlots.back();
+    this->freeSlots.pop_back();
+  }
+  else
+  {
+    slot = this->models.size();
+    this->models.emplace_back();
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      this->boxMin[axis].push_back(0.0);
+      this->boxMax[axis].push_back(0.0);
+    }
+  }
+
+  ModelEntry &entry = this->models[slot];
+  entry = ModelEntry();
+  entry.model = _model;
+  entry.name = _model->GetScopedName();
+  entry.isStatic = _model->IsStatic();
+  this->slotsByName[entry.name] = slot;
+  if (!entry.isStatic)
+    this->dynamicSlots.push_back(slot);
+
+  this->UpdateModel(slot, true);
+  return slot;
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::RemoveModel(size_t _slot)
+{
+  ModelEntry &entry = this->models[_slot];
+  this->BinModel(_slot, false);
+  this->slotsByName.erase(entry.name);
+  this->dynamicSlots.erase(
+    std::remove(this->dynamicSlots.begin(), this->dynamicSlots.end(), _slot),
+    this->dynamicSlots.end());
+  entry.model.reset();
+  entry.name.clear();
+  this->freeSlots.push_back(_slot);
+}
+
+/////////////////////////////////////////////////
+bool LogicalPerceptionEngine::UpdateModel(size_t _slot, bool _force)
+{
+  ModelEntry &entry = this->models[_slot];
+  physics::ModelPtr model = entry.model.lock();
+  if (!model)
+    return false;
+
+  // The bounding box is the union of the boxes of the links
+  bool moved = _force;
+  ignition::math::Pose3d pose = model->WorldPose();
+  if (pose != entry.pose)
+  {
+    entry.pose = pose;
+    moved = true;
+  }
+  const physics::Link_V &links = model->GetLinks();
+  if (links.size() != entry.linkPoses.size())
+  {
+    entry.linkPoses.resize(links.size());
+    moved = true;
+  }
+  for (size_t i = 0; i < links.size(); ++i)
+  {
+    ignition::math::Pose3d linkPose = links[i]->WorldPose();
+    if (linkPose != entry.linkPoses[i])
+    {
+      entry.linkPoses[i] = linkPose;
+      moved = true;
+    }
+  }
+  if (!moved)
+    return true;
+
+  ignition::math::Box box = model->BoundingBox();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    this->boxMin[axis][_slot] = box.Min()[axis];
+    this->boxMax[axis][_slot] = box.Max()[axis];
+  }
+
+  // Compute the cells covered by the box
+  bool valid = true;
+  double cellCount = 1.0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    double extent = box.Max()[axis] - box.Min()[axis];
+    valid &= std::isfinite(extent) && extent >= 0.0;
+    cellCount *= std::floor(box.Max()[axis] / this->cellSize) -
+                 std::floor(box.Min()[axis] / this->cellSize) + 1.0;
+  }
+  bool large = valid && !(cellCount <= kMaxModelCells);
+  int cellMin[3] = {1, 1, 1};
+  int cellMax[3] = {0, 0, 0};
+  if (valid && !large)
+    CellRange(box.Min(), box.Max(), this->cellSize, cellMin, cellMax);
+
+  if (!_force && large == entry.large &&
+      std::equal(cellMin, cellMin + 3, entry.cellMin) &&
+      std::equal(cellMax, cellMax + 3, entry.cellMax))
+  {
+    return true;
+  }
+
+  if (!_force)
+    this->BinModel(_slot, false);
+  entry.large = large;
+  std::copy(cellMin, cellMin + 3, entry.cellMin);
+  std::copy(cellMax, cellMax + 3, entry.cellMax);
+  this->BinModel(_slot, true);
+  return true;
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::BinModel(size_t _slot, bool _insert)
+{
+  const ModelEntry &entry = this->models[_slot];
+  if (entry.large)
+  {
+    if (_insert)
+    {
+      this->largeSlots.push_back(_slot);
+    }
+    else
+    {
+      this->largeSlots.erase(
+        std::remove(this->largeSlots.begin(), this->largeSlots.end(), _slot),
+        this->largeSlots.end());
+    }
+    return;
+  }
+
+  // Models without a valid bounding box have an empty cell range
+  for (int x = entry.cellMin[0]; x <= entry.cellMax[0]; ++x)
+  {
+    for (int y = entry.cellMin[1]; y <= entry.cellMax[1]; ++y)
+    {
+      for (int z = entry.cellMin[2]; z <= entry.cellMax[2]; ++z)
+      {
+        int64_t key = CellKey(x, y, z);
+        if (_insert)
+        {
+          this->cells[key].push_back(_slot);
+          continue;
+        }
+
+        auto cell = this->cells.find(key);
+        if (cell == this->cells.end())
+          continue;
+        auto &slots = cell->second;
+        slots.erase(std::remove(slots.begin(), slots.end(), _slot), slots.end());
+        if (slots.empty())
+          this->cells.erase(cell);
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionEngine::EvaluateCamera(CameraEntry &_camera, const common::Time &_time)
+{
+  const LogicalCameraParams &params = _camera.params;
+  if (!params.link)
+    return;
+  ignition::math::Pose3d cameraPose = params.pose + params.link->WorldPose();
+  LogicalCameraFrustum frustum(params, cameraPose);
+
+  // Gather the models of the cells covered by the frustum, once each
+  ++this->queryStamp;
+  this->candidates.clear();
+  for (auto slot : this->largeSlots)
+  {
+    this->models[slot].queryStamp = this->queryStamp;
+    this->candidates.push_back(slot);
+  }
+  int cellMin[3];
+  int cellMax[3];
+  CellRange(frustum.Min(), frustum.Max(), this->cellSize, cellMin, cellMax);
+  for (int x = cellMin[0]; x <= cellMax[0]; ++x)
+  {
+    for (int y = cellMin[1]; y <= cellMax[1]; ++y)
+    {
+      for (int z = cellMin[2]; z <= cellMax[2]; ++z)
+      {
+        auto cell = this->cells.find(CellKey(x, y, z));
+        if (cell == this->cells.end())
+          continue;
+        for (auto slot : cell->second)
+        {
+          if (this->models[slot].queryStamp == this->queryStamp)
+            continue;
+          this->models[slot].queryStamp = this->queryStamp;
+          this->candidates.push_back(slot);
+        }
+      }
+    }
+  }
+
+  // Copy the boxes of the candidates to contiguous arrays
+  size_t count = this->candidates.size();
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    this->candidateMin[axis].resize(count);
+    this->candidateMax[axis].resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      this->candidateMin[axis][i] = this->boxMin[axis][this->candidates[i]];
+      this->candidateMax[axis][i] = this->boxMax[axis][this->candidates[i]];
+    }
+  }
+
+  this->outside.assign(count, 0);
+  uint8_t *outsideData = this->outside.data();
+  const double *const candidateMin[3] = {
+    this->candidateMin[0].data(), this->candidateMin[1].data(), this->candidateMin[2].data()};
+  const double *const candidateMax[3] = {
+    this->candidateMax[0].data(), this->candidateMax[1].data(), this->candidateMax[2].data()};
+  frustum.FlagOutside(count, candidateMin, candidateMax, outsideData);
+
+  // Fill the image like a logical camera sensor would
+  msgs::LogicalCameraImage &image = *_camera.image;
+  msgs::Set(image.mutable_pose(), cameraPose);
+  image.mutable_model()->Clear();
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (outsideData[i])
+      continue;
+    const ModelEntry &entry = this->models[this->candidates[i]];
+    if (entry.name == params.parentModel)
+      continue;
+    auto modelMsg = image.add_model();
+    modelMsg->set_name(entry.name);
+    msgs::Set(modelMsg->mutable_pose(), entry.pose - cameraPose);
+  }
+
+  ConstLogicalCameraImagePtr constImage = _camera.image;
+  _camera.callback(constImage, _time);
+}
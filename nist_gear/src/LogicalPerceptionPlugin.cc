@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gazebo/common/Assert.hh>
+#include <gazebo/common/Console.hh>
+#include <gazebo/physics/World.hh>
+
+#include "nist_gear/LogicalPerceptionEngine.hh"
+#include "nist_gear/LogicalPerceptionPlugin.hh"
+
+using namespace gazebo;
+
+GZ_REGISTER_WORLD_PLUGIN(LogicalPerceptionPlugin)
+
+/////////////////////////////////////////////////
+LogicalPerceptionPlugin::LogicalPerceptionPlugin()
+{
+}
+
+/////////////////////////////////////////////////
+LogicalPerceptionPlugin::~LogicalPerceptionPlugin()
+{
+}
+
+/////////////////////////////////////////////////
+void LogicalPerceptionPlugin::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf)
+{
+  GZ_ASSERT(_world, "LogicalPerceptionPlugin world pointer is NULL");
+
+  double cellSize = 0.5;
+  if (_sdf->HasElement("cell_size"))
+  {
+    cellSize = _sdf->Get<double>("cell_size");
+  }
+  if (cellSize <= 0)
+  {
+    gzerr << "LogicalPerceptionPlugin: <cell_size> must be positive, using 0.5" << std::endl;
+    cellSize = 0.5;
+  }
+
+  LogicalPerceptionEngine::Instance().Enable(_world, cellSize);
+  gzdbg << "LogicalPerceptionPlugin: evaluating the logical cameras of " << _world->Name()
+        << " with " << cellSize << " m cells" << std::endl;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gazebo/common/Console.hh>
+#include <gazebo/physics/Link.hh>
+#include <gazebo/physics/Model.hh>
+
+#include "nist_gear/ARIAC.hh"
+#include "nist_gear/ModelPool.hh"
+
+using namespace gazebo;
+
+/// \brief Number of parking slots in a row below the floor.
+static const unsigned int kSlotsPerRow = 100;
+
+/////////////////////////////////////////////////
+ModelPool &ModelPool::Instance()
+{
+  static ModelPool instance;
+  return instance;
+}
+
+/////////////////////////////////////////////////
+ModelPool::ModelPool()
+{
+  this->deleteEntityConnection = event::Events::ConnectDeleteEntity(
+    std::bind(&ModelPool::OnDeleteEntity, this, std::placeholders::_1));
+}
+
+/////////////////////////////////////////////////
+ignition::math::Pose3d ModelPool::SlotPose(unsigned int _slot)
+{
+  return ignition::math::Pose3d(
+    0.25 * (_slot % kSlotsPerRow), 0.25 * (_slot / kSlotsPerRow), -5, 0, 0, 0);
+}
+
+/////////////////////////////////////////////////
+void ModelPool::Release(const physics::ModelPtr &_model)
+{
+  if (!_model)
+    return;
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  const std::string name = _model->GetScopedName();
+  if (this->parked.count(name))
+    return;
+
+  unsigned int slot;
+  if (!this->freeSlots.empty())
+  {
+    slot = this->freeSlots.back();
+    this->freeSlots.pop_back();
+  }
+  else
+  {
+    slot = this->slotCount++;
+  }
+
+  gzdbg << "Parking model: " << name << " in slot " << slot << std::endl;
+  for (auto link : _model->GetLinks())
+  {
+    link->SetCollideMode("none");
+    link->SetGravityMode(false);
+    link->SetEnabled(false);
+  }
+  _model->SetLinearVel(ignition::math::Vector3d::Zero);
+  _model->SetAngularVel(ignition::math::Vector3d::Zero);
+  _model->SetWorldPose(SlotPose(slot));
+
+  ParkedModel entry;
+  entry.model = _model;
+  entry.type = ariac::DetermineModelType(_model->GetName());
+  entry.slot = slot;
+  this->available[entry.type].push_back(name);
+  this->parked.emplace(name, std::move(entry));
+}
+
+/////////////////////////////////////////////////
+physics::ModelPtr ModelPool::Acquire(const std::string &_type)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->available.find(_type);
+  if (it == this->available.end())
+    return nullptr;
+
+  // Names of reclaimed or deleted models are skipped
+  physics::ModelPtr model;
+  while (!model && !it->second.empty())
+  {
+    std::string name = it->second.front();
+    it->second.pop_front();
+    model = this->Unpark(name);
+  }
+  return model;
+}
+
+/////////////////////////////////////////////////
+bool ModelPool::Reclaim(const physics::ModelPtr &_model)
+{
+  if (!_model)
+    return false;
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  const std::string name = _model->GetScopedName();
+  if (!this->parked.count(name))
+    return false;
+
+  this->Unpark(name);
+  return true;
+}
+
+/////////////////////////////////////////////////
+physics::ModelPtr ModelPool::Unpark(const std::string &_name)
+{
+  auto it = this->parked.find(_name);
+  if (it == this->parked.end())
+    return nullptr;
+
+  physics::ModelPtr model = it->second.model.lock();
+  this->freeSlots.push_back(it->second.slot);
+  this->parked.erase(it);
+  if (!model)
+    return nullptr;
+
+  gzdbg << "Unparking model: " << _name << std::endl;
+  for (auto link : model->GetLinks())
+  {
+    link->SetEnabled(true);
+    link->SetGravityMode(true);
+    link->SetCollideMode("all");
+  }
+  return model;
+}
+
+/////////////////////////////////////////////////
+bool ModelPool::IsParked(const std::string &_name)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->parked.count(_name) > 0;
+}
+
+/////////////////////////////////////////////////
+size_t ModelPool::Size()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->parked.size();
+}
+
+/////////////////////////////////////////////////
+void ModelPool::OnDeleteEntity(const std::string &_name)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->parked.find(_name);
+  if (it == this->parked.end())
+    return;
+
+  // The name stays in the available queue and is skipped by Acquire()
+  this->freeSlots.push_back(it->second.slot);
+  this->parked.erase(it);
+}
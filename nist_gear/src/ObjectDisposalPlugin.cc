@@ -21,6 +21,7 @@
 #include <ignition/math/Box.hh>
 
 #include "ObjectDisposalPlugin.hh"
+#include "nist_gear/ModelPool.hh"
 
 using namespace gazebo;
 GZ_REGISTER_MODEL_PLUGIN(ObjectDisposalPlugin)
@@ -54,13 +55,21 @@ void ObjectDisposalPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
     this->centerOfGravityCheck = _sdf->Get<bool>("center_of_gravity_check");
   }
 
-  if (!_sdf->HasElement("disposal_pose"))
+  if (_sdf->HasElement("recycle_models"))
+  {
+    this->recycleModels = _sdf->Get<bool>("recycle_models");
+  }
+
+  if (!_sdf->HasElement("disposal_pose") && !this->recycleModels)
   {
     gzerr << "ObjectDisposalPlugin: Unable to find <disposal_pose> element\n";
     return;
   }
 
-  this->disposalPose = _sdf->Get<ignition::math::Pose3d>("disposal_pose");
+  if (_sdf->HasElement("disposal_pose"))
+  {
+    this->disposalPose = _sdf->Get<ignition::math::Pose3d>("disposal_pose");
+  }
 }
 
 /////////////////////////////////////////////////
@@ -76,8 +85,13 @@ void ObjectDisposalPlugin::OnUpdate(const common::UpdateInfo &/*_info*/)
 }
 
 /////////////////////////////////////////////////
-void ObjectDisposalPlugin::ActOnContactingModels()
+void ObjectDisposalPlugin::UpdateDisposalBox()
 {
+  // The link rarely moves, so the bounding box is only recomputed when it does
+  auto linkPose = this->parentLink->WorldPose();
+  if (this->disposalBoxValid && linkPose == this->disposalBoxLinkPose)
+    return;
+
   // Only remove models if their center of gravity is "above" the link
   // TODO: make more general than just z axis
   auto linkBox = this->parentLink->BoundingBox();
@@ -85,33 +99,98 @@ void ObjectDisposalPlugin::ActOnContactingModels()
   auto linkBoxMin = linkBox.Min();
   linkBoxMin.Z() = std::numeric_limits<double>::lowest();
   linkBoxMax.Z() = std::numeric_limits<double>::max();
-  auto disposalBox = ignition::math::Box(linkBoxMin, linkBoxMax);
+  this->disposalBox = ignition::math::Box(linkBoxMin, linkBoxMax);
+  this->disposalBoxLinkPose = linkPose;
+  this->disposalBoxValid = true;
+}
+
+/////////////////////////////////////////////////
+const ObjectDisposalPlugin::ModelMassTable &ObjectDisposalPlugin::MassTable(
+  const physics::ModelPtr &_model, std::unordered_map<std::string, ModelMassTable> &_tables)
+{
+  const std::string name = _model->GetScopedName();
+  auto &table = this->massTables[name];
+  auto previous = _tables.find(name);
+  if (previous != _tables.end() && previous->second.model == _model)
+  {
+    table = std::move(previous->second);
+  }
+  else if (table.model != _model)
+  {
+    table = ModelMassTable();
+    table.model = _model;
+    for (auto modelLink : _model->GetLinks())
+    {
+      double linkMass = modelLink->GetInertial()->Mass();
+      table.links.push_back(modelLink);
+      table.masses.push_back(linkMass);
+      table.totalMass += linkMass;
+    }
+  }
+  return table;
+}
 
+/////////////////////////////////////////////////
+void ObjectDisposalPlugin::ActOnContactingModels()
+{
+  std::vector<physics::ModelPtr> models;
+  models.reserve(this->contactingModels.size());
   for (auto model : this->contactingModels) {
-    if (model) {
-      bool removeModel = true;
-      if (this->centerOfGravityCheck)
+    if (model)
+      models.push_back(model);
+  }
+
+  std::vector<bool> removeModel(models.size(), true);
+  if (this->centerOfGravityCheck && !models.empty())
+  {
+    this->UpdateDisposalBox();
+
+    // Only the tables of the models still in contact are kept
+    std::unordered_map<std::string, ModelMassTable> previousTables;
+    previousTables.swap(this->massTables);
+
+    // Gather the center of gravity of every model, then test them all at once
+    std::vector<double> cogX(models.size(), 0.0);
+    std::vector<double> cogY(models.size(), 0.0);
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+      const auto &table = this->MassTable(models[i], previousTables);
+      ignition::math::Vector3d modelCog = ignition::math::Vector3d::Zero;
+      for (size_t j = 0; j < table.links.size(); ++j)
       {
-        // Calculate the center of gravity of the model
-        ignition::math::Vector3d modelCog = ignition::math::Vector3d::Zero;
-        double modelMass = 0.0;
-        for (auto modelLink : model->GetLinks())
-        {
-          double linkMass = modelLink->GetInertial()->Mass();
-          modelCog += modelLink->WorldCoGPose().Pos() * linkMass;
-          modelMass += linkMass;
-        }
-        if (modelMass > 0.0)
-        {
-          modelCog /= modelMass;
-        }
-        removeModel = disposalBox.Contains(modelCog);
+        modelCog += table.links[j]->WorldCoGPose().Pos() * table.masses[j];
       }
-      if (removeModel)
+      if (table.totalMass > 0.0)
       {
-        gzdbg << "[" << this->model->GetName() << "] Removing model: " << model->GetName() << "\n";
-        model->SetWorldPose(this->disposalPose);
+        modelCog /= table.totalMass;
       }
+      cogX[i] = modelCog.X();
+      cogY[i] = modelCog.Y();
+    }
+
+    // z is unbounded, so only x and y need to be checked
+    const double minX = this->disposalBox.Min().X();
+    const double maxX = this->disposalBox.Max().X();
+    const double minY = this->disposalBox.Min().Y();
+    const double maxY = this->disposalBox.Max().Y();
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+      removeModel[i] = cogX[i] >= minX && cogX[i] <= maxX &&
+                       cogY[i] >= minY && cogY[i] <= maxY;
     }
   }
+
+  for (size_t i = 0; i < models.size(); ++i)
+  {
+    if (!removeModel[i])
+      continue;
+
+    auto model = models[i];
+    gzdbg << "[" << this->model->GetName() << "] Removing model: " << model->GetName() << "\n";
+    this->massTables.erase(model->GetScopedName());
+    if (this->recycleModels)
+      ModelPool::Instance().Release(model);
+    else
+      model->SetWorldPose(this->disposalPose);
+  }
 }
@@ -33,6 +33,8 @@
 #include <ignition/math/Pose3.hh>
 #include <sdf/sdf.hh>
 
+#include "nist_gear/EntityCache.hh"
+#include "nist_gear/ModelPool.hh"
 #include "nist_gear/PopulationPlugin.hh"
 
 namespace gazebo
@@ -396,7 +398,19 @@ void PopulationPlugin::OnUpdate()
 
     // Get a unique name for the object.
     modelName += "_" + std::to_string(index);
-    auto modelPtr = this->dataPtr->world->ModelByName(modelName);
+    auto modelPtr = EntityCache::Instance().ModelByName(this->dataPtr->world, modelName);
+    if (modelPtr)
+    {
+      // The model may have been cleared or disposed earlier in the run
+      ModelPool::Instance().Reclaim(modelPtr);
+    }
+    else
+    {
+      // Reuse a recycled model of the same type, e.g. when looping forever
+      modelPtr = ModelPool::Instance().Acquire(obj.type);
+      if (modelPtr)
+        modelName = modelPtr->GetScopedName();
+    }
     if (modelPtr)
     {
       // Move it to the target pose.
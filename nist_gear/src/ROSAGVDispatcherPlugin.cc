@@ -0,0 +1,574 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/bind.hpp>
+#include <gazebo/common/Assert.hh>
+#include <gazebo/common/Events.hh>
+#include <gazebo/msgs/gz_string.pb.h>
+#include <gazebo/physics/World.hh>
+#include <gazebo/transport/transport.hh>
+#include <ros/ros.h>
+#include <sdf/sdf.hh>
+
+#include "nist_gear/ARIAC.hh"
+#include "nist_gear/ROSAGVDispatcherPlugin.hh"
+
+namespace gazebo
+{
+  /// \internal
+  /// \brief Dispatcher view of one AGV.
+  struct AGVDispatchInfo
+  {
+    /// \brief Name of the AGV, e.g. agv1.
+  public:
+    std::string name;
+
+    /// \brief Lane the AGV drives on.
+  public:
+    std::string lane;
+
+    /// \brief Lowest assembly station the AGV can reach (1 or 4).
+  public:
+    int firstStation = 1;
+
+    /// \brief ROS parameter holding the initial station of the AGV.
+  public:
+    std::string stationParam;
+
+    /// \brief Station the AGV is docked at, as last reported by its
+    /// telemetry. Empty until known.
+  public:
+    std::string station;
+
+    /// \brief ROS parameter holding the move durations of the AGV, set by
+    /// ROSAGVPlugin.
+  public:
+    std::string moveDurationsParam;
+
+    /// \brief Duration of the moves between lane nodes, indexed by
+    /// 4 * from + to. Empty until read.
+  public:
+    std::vector<double> moveDurations;
+
+    /// \brief Last state reported by the AGV.
+  public:
+    std::string state = "ready_to_deliver";
+
+    /// \brief Gazebo publisher used to start a move.
+  public:
+    transport::PublisherPtr dispatchPub;
+
+    /// \brief ROS subscriber to the state of the AGV.
+  public:
+    ros::Subscriber stateSub;
+
+    /// \brief ROS subscriber to the telemetry of the AGV.
+  public:
+    ros::Subscriber telemetrySub;
+  };
+
+  /// \internal
+  /// \brief A move requested to the dispatcher.
+  struct AGVMove
+  {
+    /// \brief Unique id of the move.
+  public:
+    unsigned int id = 0;
+
+    /// \brief Name of the AGV to move.
+  public:
+    std::string agv;
+
+    /// \brief Destination station ("KS" or "AS1".."AS6").
+  public:
+    std::string station;
+
+    /// \brief Lane node the move starts from.
+  public:
+    int from = 0;
+
+    /// \brief Lane node the move ends at.
+  public:
+    int to = 0;
+
+    /// \brief Resources (AGV, lane segments, lane nodes) reserved by the move.
+  public:
+    std::set<std::string> resources;
+
+    /// \brief Expected duration of the move, trigger delay included.
+  public:
+    double duration = 0;
+
+    /// \brief Simulation time when the move was started.
+  public:
+    common::Time startTime;
+
+    /// \brief Expected simulation time of arrival.
+  public:
+    common::Time arrivalTime;
+
+    /// \brief Whether the AGV has left the ready state since the move started.
+  public:
+    bool sawMoving = false;
+
+    /// \brief Whether the AGV reported its arrival at the destination.
+  public:
+    bool arrived = false;
+  };
+
+  /// \internal
+  /// \brief Private data for the ROSAGVDispatcherPlugin class.
+  struct ROSAGVDispatcherPluginPrivate
+  {
+    /// \brief World pointer.
+  public:
+    physics::WorldPtr world;
+
+    /// \brief ROS node handle.
+  public:
+    std::unique_ptr<ros::NodeHandle> rosnode;
+
+    /// \brief Gazebo transport node.
+  public:
+    transport::NodePtr gzNode;
+
+    /// \brief Service receiving move requests.
+  public:
+    ros::ServiceServer dispatchService;
+
+    /// \brief Managed AGVs, by name.
+  public:
+    std::map<std::string, AGVDispatchInfo> agvs;
+
+    /// \brief Moves waiting for their reservations, in request order.
+  public:
+    std::deque<AGVMove> queuedMoves;
+
+    /// \brief Moves being executed.
+  public:
+    std::vector<AGVMove> activeMoves;
+
+    /// \brief Id of the next move.
+  public:
+    unsigned int nextMoveId = 1;
+
+    /// \brief Extra time given to a move past its expected arrival before its
+    /// reservations are released.
+  public:
+    double moveTimeout = 30.0;
+
+    /// \brief Protects the AGVs and the moves.
+  public:
+    std::mutex mutex;
+
+    /// \brief Connection to the world update event.
+  public:
+    event::ConnectionPtr updateConnection;
+  };
+}
+
+using namespace gazebo;
+
+GZ_REGISTER_WORLD_PLUGIN(ROSAGVDispatcherPlugin)
+
+/// \brief Delay between a move being triggered and the AGV starting to move.
+static const double kTriggerDelay = 0.75;
+
+/////////////////////////////////////////////////
+ROSAGVDispatcherPlugin::ROSAGVDispatcherPlugin()
+    : dataPtr(new ROSAGVDispatcherPluginPrivate)
+{
+}
+
+/////////////////////////////////////////////////
+ROSAGVDispatcherPlugin::~ROSAGVDispatcherPlugin()
+{
+  if (this->dataPtr->rosnode)
+    this->dataPtr->rosnode->shutdown();
+}
+
+/////////////////////////////////////////////////
+void ROSAGVDispatcherPlugin::Load(physics::WorldPtr _world,
+                                  sdf::ElementPtr _sdf)
+{
+  GZ_ASSERT(_world, "ROSAGVDispatcherPlugin world pointer is NULL");
+  GZ_ASSERT(_sdf, "ROSAGVDispatcherPlugin sdf pointer is NULL");
+  this->dataPtr->world = _world;
+
+  // Make sure the ROS node for Gazebo has already been initialized
+  if (!ros::isInitialized())
+  {
+    ROS_FATAL_STREAM("A ROS node for Gazebo has not been initialized,"
+                     << "unable to load plugin. Load the Gazebo system plugin "
+                     << "'libgazebo_ros_api_plugin.so' in the gazebo_ros package)");
+    return;
+  }
+
+  std::string robotNamespace = "";
+  if (_sdf->HasElement("robot_namespace"))
+  {
+    robotNamespace = _sdf->GetElement(
+                             "robot_namespace")
+                         ->Get<std::string>() +
+                     "/";
+  }
+
+  std::string dispatchServiceName = "agv_dispatch";
+  if (_sdf->HasElement("dispatch_service_name"))
+    dispatchServiceName = _sdf->Get<std::string>("dispatch_service_name");
+
+  if (_sdf->HasElement("move_timeout"))
+    this->dataPtr->moveTimeout = _sdf->Get<double>("move_timeout");
+
+  // Initialize Gazebo transport.
+  this->dataPtr->gzNode = transport::NodePtr(new transport::Node());
+  this->dataPtr->gzNode->Init();
+
+  // Initialize ROS
+  this->dataPtr->rosnode.reset(new ros::NodeHandle(robotNamespace));
+
+  // Collect the AGVs to manage.
+  std::vector<std::pair<std::string, std::string>> agvLanes;
+  std::vector<std::string> dispatchTopics;
+  if (_sdf->HasElement("agv"))
+  {
+    sdf::ElementPtr agvElem = _sdf->GetElement("agv");
+    while (agvElem)
+    {
+      if (!agvElem->HasElement("name"))
+      {
+        gzerr << "ROSAGVDispatcherPlugin: <agv> without <name>, skipping" << std::endl;
+        agvElem = agvElem->GetNextElement("agv");
+        continue;
+      }
+      std::string name = agvElem->Get<std::string>("name");
+      std::string lane = name;
+      if (agvElem->HasElement("lane"))
+        lane = agvElem->Get<std::string>("lane");
+      std::string topic = "/ariac/" + name + "/dispatch";
+      if (agvElem->HasElement("dispatch_topic"))
+        topic = agvElem->Get<std::string>("dispatch_topic");
+      agvLanes.push_back({name, lane});
+      dispatchTopics.push_back(topic);
+      agvElem = agvElem->GetNextElement("agv");
+    }
+  }
+  else
+  {
+    for (int i = 1; i <= 4; ++i)
+    {
+      std::string name = "agv" + std::to_string(i);
+      agvLanes.push_back({name, name});
+      dispatchTopics.push_back("/ariac/" + name + "/dispatch");
+    }
+  }
+
+  for (size_t i = 0; i < agvLanes.size(); ++i)
+  {
+    const std::string &name = agvLanes[i].first;
+    AGVDispatchInfo &info = this->dataPtr->agvs[name];
+    info.name = name;
+    info.lane = agvLanes[i].second;
+    info.stationParam = "/ariac/" + name + "_station";
+    info.moveDurationsParam = "/ariac/" + name + "_move_durations";
+    // agv1 and agv2 serve AS1..AS3, agv3 and agv4 serve AS4..AS6.
+    size_t digit = name.find_first_of("0123456789");
+    int index = digit == std::string::npos ? 0 : std::atoi(name.c_str() + digit);
+    info.firstStation = index >= 3 ? 4 : 1;
+    info.dispatchPub = this->dataPtr->gzNode->Advertise<msgs::GzString>(dispatchTopics[i]);
+    info.stateSub = this->dataPtr->rosnode->subscribe<std_msgs::String>(
+        "/ariac/" + name + "/state", 10,
+        boost::bind(&ROSAGVDispatcherPlugin::OnAGVState, this, _1, name));
+    info.telemetrySub = this->dataPtr->rosnode->subscribe(
+        "/ariac/" + name + "/telemetry", 10, &ROSAGVDispatcherPlugin::OnAGVTelemetry, this);
+  }
+
+  this->dataPtr->dispatchService = this->dataPtr->rosnode->advertiseService(
+      dispatchServiceName, &ROSAGVDispatcherPlugin::HandleDispatchService, this);
+
+  this->dataPtr->updateConnection = event::Events::ConnectWorldUpdateBegin(
+      boost::bind(&ROSAGVDispatcherPlugin::OnUpdate, this));
+}
+
+/////////////////////////////////////////////////
+void ROSAGVDispatcherPlugin::OnUpdate()
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (this->dataPtr->queuedMoves.empty() && this->dataPtr->activeMoves.empty())
+    return;
+  this->ProcessMoves();
+}
+
+/////////////////////////////////////////////////
+void ROSAGVDispatcherPlugin::OnAGVState(const std_msgs::String::ConstPtr &_msg,
+                                        const std::string &_agvName)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->agvs[_agvName].state = _msg->data;
+}
+
+/////////////////////////////////////////////////
+void ROSAGVDispatcherPlugin::OnAGVTelemetry(const nist_gear::AGVTelemetry::ConstPtr &_msg)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto agvIt = this->dataPtr->agvs.find(_msg->agv_name);
+  if (agvIt != this->dataPtr->agvs.end() && _msg->state == "ready_to_deliver")
+    agvIt->second.station = _msg->to_station;
+
+  for (auto &move : this->dataPtr->activeMoves)
+  {
+    if (move.agv != _msg->agv_name || !move.sawMoving)
+      continue;
+    // The telemetry ETA accounts for the actual start of the animation.
+    move.arrivalTime = common::Time(_msg->eta.sec, _msg->eta.nsec);
+    if (_msg->arrived && (_msg->to_station == move.station ||
+                          (move.station == "KS" && _msg->to_station.compare(0, 2, "KS") == 0)))
+      move.arrived = true;
+  }
+}
+
+/////////////////////////////////////////////////
+bool ROSAGVDispatcherPlugin::HandleDispatchService(
+    nist_gear::AGVDispatch::Request &_req,
+    nist_gear::AGVDispatch::Response &_res)
+{
+  // Read the data the AGV shares through the parameter server before taking
+  // the lock, which the world update waits on. The parameter names don't
+  // change after Load.
+  std::string paramStation;
+  std::vector<double> paramDurations;
+  auto paramIt = this->dataPtr->agvs.find(_req.agv_name);
+  if (paramIt != this->dataPtr->agvs.end())
+  {
+    bool needStation;
+    bool needDurations;
+    {
+      std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+      needStation = paramIt->second.station.empty();
+      needDurations = paramIt->second.moveDurations.empty();
+    }
+    if (needStation)
+      this->dataPtr->rosnode->getParam(paramIt->second.stationParam, paramStation);
+    if (needDurations)
+      this->dataPtr->rosnode->getParam(paramIt->second.moveDurationsParam, paramDurations);
+  }
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+
+  _res.success = false;
+  _res.queued = false;
+  _res.eta = -1;
+
+  auto agvIt = this->dataPtr->agvs.find(_req.agv_name);
+  if (agvIt == this->dataPtr->agvs.end())
+  {
+    _res.message = "[" + _req.agv_name + "] FAILURE: unknown AGV.";
+    ROS_ERROR_STREAM(_res.message);
+    return true;
+  }
+  AGVDispatchInfo &agv = agvIt->second;
+
+  std::string station = _req.station_name;
+  std::transform(station.begin(), station.end(), station.begin(), ::toupper);
+  int to = ariac::AGVLaneNode(station);
+  if (to > 0 && (station[2] - '0' < agv.firstStation || station[2] - '0' > agv.firstStation + 2))
+    to = -1;
+  if (to < 0)
+  {
+    _res.message = "[" + agv.name + "->" + _req.station_name + "] FAILURE: station not reachable.";
+    ROS_ERROR_STREAM(_res.message);
+    return true;
+  }
+  if (to == 0)
+    station = "KS";
+
+  // The telemetry keeps the station up to date once it is known.
+  if (agv.station.empty())
+    agv.station = paramStation;
+  if (agv.moveDurations.empty() && paramDurations.size() == 16)
+    agv.moveDurations = paramDurations;
+  if (agv.moveDurations.empty())
+  {
+    ROS_WARN_STREAM("[" << agv.name << "] move durations not available in "
+                        << agv.moveDurationsParam << ", the ETA relies on the telemetry.");
+  }
+
+  // The move starts where the last move of this AGV ends.
+  std::string origin = agv.station;
+  for (const auto &move : this->dataPtr->activeMoves)
+    if (move.agv == agv.name)
+      origin = move.station;
+  for (const auto &move : this->dataPtr->queuedMoves)
+    if (move.agv == agv.name)
+      origin = move.station;
+  int from = std::max(ariac::AGVLaneNode(origin), 0);
+
+  if (from == to)
+  {
+    _res.message = "[" + agv.name + " already at " + station + "] FAILURE: AGV not dispatched.";
+    ROS_ERROR_STREAM(_res.message);
+    return true;
+  }
+
+  AGVMove move;
+  move.id = this->dataPtr->nextMoveId++;
+  move.agv = agv.name;
+  move.station = station;
+  move.from = from;
+  move.to = to;
+  move.duration = kTriggerDelay;
+  if (!agv.moveDurations.empty())
+    move.duration += agv.moveDurations[4 * from + to];
+  move.resources.insert("agv/" + agv.name);
+  for (int i = std::min(from, to); i < std::max(from, to); ++i)
+  {
+    move.resources.insert(agv.lane + "/segment" + std::to_string(i));
+    // Kitting stations are not shared, only assembly station nodes are.
+    if (i + 1 != from)
+      move.resources.insert(agv.lane + "/node" + std::to_string(i + 1));
+  }
+
+  // Arrival estimate: after every earlier move holding one of our resources.
+  common::Time now = this->dataPtr->world->SimTime();
+  common::Time readyTime = now;
+  auto conflicts = [&move](const AGVMove &_other) {
+    for (const auto &resource : _other.resources)
+      if (move.resources.count(resource))
+        return true;
+    return false;
+  };
+  for (const auto &other : this->dataPtr->activeMoves)
+    if (conflicts(other) && other.arrivalTime > readyTime)
+      readyTime = other.arrivalTime;
+  for (const auto &other : this->dataPtr->queuedMoves)
+    if (conflicts(other) && other.arrivalTime > readyTime)
+      readyTime = other.arrivalTime;
+  move.arrivalTime = readyTime + move.duration;
+
+  this->dataPtr->queuedMoves.push_back(move);
+  this->ProcessMoves();
+
+  _res.queued = std::find_if(this->dataPtr->queuedMoves.begin(), this->dataPtr->queuedMoves.end(),
+                             [&move](const AGVMove &_m) { return _m.id == move.id; }) !=
+                this->dataPtr->queuedMoves.end();
+  _res.eta = (move.arrivalTime - now).Double();
+  _res.success = true;
+  _res.message = "[" + agv.name + "->" + station + "] SUCCESS: AGV " +
+                 (_res.queued ? "queued." : "dispatched.");
+  ROS_INFO_STREAM(_res.message << " ETA: " << _res.eta << " s");
+  return true;
+}
+
+/////////////////////////////////////////////////
+void ROSAGVDispatcherPlugin::ProcessMoves()
+{
+  common::Time now = this->dataPtr->world->SimTime();
+
+  // Release the moves that are done.
+  auto &active = this->dataPtr->activeMoves;
+  for (auto it = active.begin(); it != active.end();)
+  {
+    const std::string &state = this->dataPtr->agvs[it->agv].state;
+    bool done = false;
+    if (state != "ready_to_deliver")
+      it->sawMoving = true;
+    else if (it->sawMoving)
+      done = true;
+    if (it->arrived)
+      done = true;
+
+    if (done)
+    {
+      this->dataPtr->agvs[it->agv].station = it->station;
+    }
+    else if (now > it->arrivalTime + this->dataPtr->moveTimeout)
+    {
+      ROS_WARN_STREAM("[" << it->agv << "->" << it->station
+                          << "] move timed out, releasing its reservations.");
+      // The station is unknown until the telemetry reports it.
+      this->dataPtr->agvs[it->agv].station.clear();
+      done = true;
+    }
+
+    if (done)
+      it = active.erase(it);
+    else
+      ++it;
+  }
+
+  // Resources held by the active moves.
+  std::set<std::string> held;
+  for (const auto &move : active)
+    held.insert(move.resources.begin(), move.resources.end());
+
+  // Assembly stations where idle AGVs are parked block the lane node.
+  std::map<std::string, std::string> parked;
+  for (const auto &agvPair : this->dataPtr->agvs)
+  {
+    if (held.count("agv/" + agvPair.first))
+      continue;
+    int node = ariac::AGVLaneNode(agvPair.second.station);
+    if (node > 0)
+      parked[agvPair.second.lane + "/node" + std::to_string(node)] = agvPair.first;
+  }
+
+  // Start the queued moves in FIFO order. A move that can't start keeps its
+  // resources claimed so that later conflicting moves do not overtake it.
+  std::set<std::string> claimed;
+  auto &queued = this->dataPtr->queuedMoves;
+  for (auto it = queued.begin(); it != queued.end();)
+  {
+    bool free = this->dataPtr->agvs[it->agv].state == "ready_to_deliver";
+    for (const auto &resource : it->resources)
+    {
+      auto parkedIt = parked.find(resource);
+      if (held.count(resource) || claimed.count(resource) ||
+          (parkedIt != parked.end() && parkedIt->second != it->agv))
+      {
+        free = false;
+        break;
+      }
+    }
+
+    if (!free)
+    {
+      claimed.insert(it->resources.begin(), it->resources.end());
+      ++it;
+      continue;
+    }
+
+    msgs::GzString msg;
+    msg.set_data(it->station);
+    this->dataPtr->agvs[it->agv].dispatchPub->Publish(msg);
+
+    it->startTime = now;
+    it->arrivalTime = now + it->duration;
+    held.insert(it->resources.begin(), it->resources.end());
+    ROS_INFO_STREAM("[" << it->agv << "->" << it->station << "] move started.");
+    active.push_back(*it);
+    it = queued.erase(it);
+  }
+}
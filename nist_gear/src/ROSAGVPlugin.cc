@@ -21,11 +21,17 @@
 #include <gazebo/common/Time.hh>
 #include <gazebo/transport/transport.hh>
 #include <ignition/math.hh>
+#include <nist_gear/AGVTelemetry.h>
+#include <nist_gear/ARIAC.hh>
 #include <nist_gear/SubmitTray.h>
 #include <std_msgs/String.h>
 #include <std_srvs/Trigger.h>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace gazebo
 {
@@ -93,6 +99,10 @@ namespace gazebo
     public:
         transport::PublisherPtr lockTrayModelsPub;
 
+        /// \brief Gazebo subscriber for move requests from the AGV dispatcher
+    public:
+        transport::SubscriberPtr dispatchSub;
+
         /// \brief Client for clearing this AGV's tray
     public:
         ros::ServiceClient rosClearTrayClient;
@@ -159,6 +169,88 @@ namespace gazebo
         ros::Publisher statePub;
         /// \brief Publishes the station where the AGV is located
         ros::Publisher stationPub;
+
+        /// \brief Publishes the AGV telemetry.
+    public:
+        ros::Publisher telemetryPub;
+
+        /// \brief Period between two telemetry messages (0 disables them).
+    public:
+        double telemetryPeriod = 0.1;
+
+        /// \brief Last time telemetry was published.
+    public:
+        common::Time lastTelemetryTime;
+
+        /// \brief Name of the kitting station of this AGV, e.g. KS1
+    public:
+        std::string kittingStationName;
+
+        /// \brief Station the AGV is docked at, or the one it left while moving
+    public:
+        std::string station;
+
+        /// \brief Station the AGV is moving to
+    public:
+        std::string destination;
+
+        /// \brief Expected arrival time at the destination
+    public:
+        common::Time eta;
+
+        /// \brief Animation of the current move, if any
+    public:
+        gazebo::common::PoseAnimationPtr activeAnimation;
+
+        /// \brief Whether the AGV is travelling between two stations
+    public:
+        bool moving = false;
+
+        /// \brief Time the current move started
+    public:
+        common::Time moveStartTime;
+
+        /// \brief When true, the AGV is not animated: it is teleported with
+        /// its tray to the destination once the travel time has elapsed.
+    public:
+        bool fastMode = false;
+
+        /// \brief Animations between lane nodes, indexed by ariac::AGVLaneNode()
+    public:
+        gazebo::common::PoseAnimationPtr moveAnimations[4][4];
+
+        /// \brief Link of the tray on the AGV
+    public:
+        physics::LinkPtr trayLink;
+
+        /// \brief Time spent in the current move.
+    public:
+        double ElapsedMoveTime(const common::Time &_time) const
+        {
+            if (this->fastMode)
+                return (_time - this->moveStartTime).Double();
+            return this->activeAnimation->GetTime();
+        }
+
+        /// \brief Duration of the animation between two stations, 0 if there is none.
+    public:
+        double MoveDuration(const std::string &_from, const std::string &_to) const
+        {
+            int from = ariac::AGVLaneNode(_from);
+            int to = ariac::AGVLaneNode(_to);
+            if (from < 0 || to < 0)
+                return 0.0;
+            return this->MoveDuration(from, to);
+        }
+
+        /// \brief Duration of the animation between two lane nodes, 0 if there is none.
+    public:
+        double MoveDuration(int _from, int _to) const
+        {
+            if (!this->moveAnimations[_from][_to])
+                return 0.0;
+            return this->moveAnimations[_from][_to]->GetLength();
+        }
     };
 } // namespace gazebo
 
@@ -218,6 +310,7 @@ void ROSAGVPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf)
     this->dataPtr->agv3Param = "/ariac/agv3_station";
     this->dataPtr->agv4Param = "/ariac/agv4_station";
 
+    this->dataPtr->kittingStationName = std::string("KS") + index;
     this->dataPtr->trayLinkName =
         this->dataPtr->agvName + "::kit_tray_" + index + "::kit_tray_" + index + "::tray";
 
@@ -282,6 +375,21 @@ void ROSAGVPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf)
         toAssemblyServiceName = _sdf->Get<std::string>("agv_to_as_service_name");
     // ROS_WARN_STREAM("Using to AS service topic: " << toAssemblyServiceName);
 
+    std::string telemetryTopic = "/ariac/" + this->dataPtr->agvName + "/telemetry";
+    if (_sdf->HasElement("telemetry_topic"))
+        telemetryTopic = _sdf->Get<std::string>("telemetry_topic");
+
+    if (_sdf->HasElement("telemetry_rate"))
+    {
+        double telemetryRate = _sdf->Get<double>("telemetry_rate");
+        this->dataPtr->telemetryPeriod = telemetryRate > 0 ? 1.0 / telemetryRate : 0.0;
+    }
+
+    std::string dispatchTopic = "/ariac/" + this->dataPtr->agvName + "/dispatch";
+    if (_sdf->HasElement("dispatch_topic"))
+        dispatchTopic = _sdf->Get<std::string>("dispatch_topic");
+    ROS_DEBUG_STREAM("Using dispatch topic: " << dispatchTopic);
+
     // std::string toKittingServiceName = "to_kitting_station";
     // if (_sdf->HasElement("agv_to_ks_service_name"))
     //     toKittingServiceName = _sdf->Get<std::string>("agv_to_ks_service_name");
@@ -296,6 +404,9 @@ void ROSAGVPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf)
     this->dataPtr->lockTrayModelsPub =
         this->dataPtr->gzNode->Advertise<msgs::GzString>(lockTrayServiceName);
 
+    this->dataPtr->dispatchSub =
+        this->dataPtr->gzNode->Subscribe(dispatchTopic, &ROSAGVPlugin::OnDispatchRequest, this);
+
     double speedFactor = 1.2;
 
     //--When simulation starts all the AGVs are at their stations
@@ -924,6 +1035,98 @@ void ROSAGVPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf)
     key->Translation(ignition::math::Vector3d(-2.265685, ypos, height));
     key->Rotation(ignition::math::Quaterniond(0, 0, yaw));
 
+    //--Animations indexed by lane node: KS, AS1/AS4, AS2/AS5, AS3/AS6
+    this->dataPtr->moveAnimations[0][1] = this->dataPtr->KS_to_AS1AS4_animation;
+    this->dataPtr->moveAnimations[0][2] = this->dataPtr->KS_to_AS2AS5_animation;
+    this->dataPtr->moveAnimations[0][3] = this->dataPtr->KS_to_AS3AS6_animation;
+    this->dataPtr->moveAnimations[1][0] = this->dataPtr->AS1AS4_to_KS_animation;
+    this->dataPtr->moveAnimations[1][2] = this->dataPtr->AS1AS4_to_AS2AS5_animation;
+    this->dataPtr->moveAnimations[1][3] = this->dataPtr->AS1AS4_to_AS3AS6_animation;
+    this->dataPtr->moveAnimations[2][0] = this->dataPtr->AS2AS5_to_KS_animation;
+    this->dataPtr->moveAnimations[2][1] = this->dataPtr->AS2AS5_to_AS1AS4_animation;
+    this->dataPtr->moveAnimations[2][3] = this->dataPtr->AS2AS5_to_AS3AS6_animation;
+    this->dataPtr->moveAnimations[3][0] = this->dataPtr->AS3AS6_to_KS_animation;
+    this->dataPtr->moveAnimations[3][1] = this->dataPtr->AS3AS6_to_AS1AS4_animation;
+    this->dataPtr->moveAnimations[3][2] = this->dataPtr->AS3AS6_to_AS2AS5_animation;
+
+    /**
+ * =========================================
+ * Travel time model
+ * =========================================
+ * <travel_time_scale> scales the duration of every move.
+ * <edge_duration from="KS" to="AS2">4.0</edge_duration> sets the duration
+ * of a single move (before scaling). AS1/AS4, AS2/AS5 and AS3/AS6 are
+ * the same lane nodes.
+ * <fast_mode> skips the animation, see ROSAGVPluginPrivate::fastMode.
+ */
+    double travelTimeScale = 1.0;
+    if (_sdf->HasElement("travel_time_scale"))
+    {
+        travelTimeScale = _sdf->Get<double>("travel_time_scale");
+        if (travelTimeScale <= 0)
+        {
+            gzerr << "Ignoring invalid <travel_time_scale> for AGV " << this->dataPtr->agvName << std::endl;
+            travelTimeScale = 1.0;
+        }
+    }
+
+    double edgeDurations[4][4];
+    for (int from = 0; from < 4; ++from)
+        for (int to = 0; to < 4; ++to)
+            edgeDurations[from][to] = this->dataPtr->MoveDuration(from, to);
+
+    if (_sdf->HasElement("edge_duration"))
+    {
+        sdf::ElementPtr edgeElem = _sdf->GetElement("edge_duration");
+        while (edgeElem)
+        {
+            int from = ariac::AGVLaneNode(edgeElem->Get<std::string>("from"));
+            int to = ariac::AGVLaneNode(edgeElem->Get<std::string>("to"));
+            double duration = edgeElem->Get<double>();
+            if (from < 0 || to < 0 || from == to || duration <= 0)
+                gzerr << "Ignoring invalid <edge_duration> for AGV " << this->dataPtr->agvName << std::endl;
+            else
+                edgeDurations[from][to] = duration;
+            edgeElem = edgeElem->GetNextElement("edge_duration");
+        }
+    }
+
+    for (int from = 0; from < 4; ++from)
+    {
+        for (int to = 0; to < 4; ++to)
+        {
+            auto &animation = this->dataPtr->moveAnimations[from][to];
+            if (!animation)
+                continue;
+            double length = edgeDurations[from][to] * travelTimeScale;
+            if (std::abs(length - animation->GetLength()) < 1e-6)
+                continue;
+
+            //--Same key frames, spread over the new duration
+            double ratio = length / animation->GetLength();
+            gazebo::common::PoseAnimationPtr scaled(
+                new gazebo::common::PoseAnimation(this->dataPtr->agvName, length, false));
+            for (unsigned int i = 0; i < animation->GetKeyFrameCount(); ++i)
+            {
+                auto source = static_cast<gazebo::common::PoseKeyFrame *>(animation->GetKeyFrame(i));
+                key = scaled->CreateKeyFrame(source->GetTime() * ratio);
+                key->Translation(source->Translation());
+                key->Rotation(source->Rotation());
+            }
+            animation = scaled;
+        }
+    }
+
+    //--Share the move durations, e.g. with the AGV dispatcher
+    std::vector<double> moveDurations;
+    for (int from = 0; from < 4; ++from)
+        for (int to = 0; to < 4; ++to)
+            moveDurations.push_back(this->dataPtr->MoveDuration(from, to));
+    this->dataPtr->rosnode->setParam("/ariac/" + this->dataPtr->agvName + "_move_durations", moveDurations);
+
+    if (_sdf->HasElement("fast_mode"))
+        this->dataPtr->fastMode = _sdf->Get<bool>("fast_mode");
+
     /**
  * =========================================
  * Advertise services
@@ -977,7 +1180,12 @@ void ROSAGVPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf)
 
     // std::string stateTopic = "/ariac/" + this->dataPtr->agvName + "/state";
 
+    // Publisher for the telemetry of the AGV.
+    this->dataPtr->telemetryPub = this->dataPtr->rosnode->advertise<
+        nist_gear::AGVTelemetry>(telemetryTopic, 10);
+
     this->dataPtr->currentState = "ready_to_deliver";
+    this->dataPtr->rosnode->getParam("/ariac/" + this->dataPtr->agvName + "_station", this->dataPtr->station);
 
     // Listen to the update event. This event is broadcast every
     // simulation iteration.
@@ -1012,6 +1220,9 @@ void ROSAGVPlugin::OnUpdate(const common::UpdateInfo &_info)
         {
             this->dataPtr->currentState = "go_to_assembly_station";
             this->dataPtr->goToAssemblyStationTriggerTime = currentSimTime;
+            this->dataPtr->destination = this->dataPtr->assemblyStationName;
+            this->dataPtr->eta = currentSimTime + 0.75 +
+                                 this->dataPtr->MoveDuration(this->dataPtr->station, this->dataPtr->destination);
         }
         this->dataPtr->goToAssemblyStationTriggered = false;
 
@@ -1024,6 +1235,9 @@ void ROSAGVPlugin::OnUpdate(const common::UpdateInfo &_info)
         {
             this->dataPtr->currentState = "go_to_kitting_station";
             this->dataPtr->goToKittingStationTriggerTime = currentSimTime;
+            this->dataPtr->destination = this->dataPtr->kittingStationName;
+            this->dataPtr->eta = currentSimTime + 0.75 +
+                                 this->dataPtr->MoveDuration(this->dataPtr->station, this->dataPtr->destination);
         }
         this->dataPtr->goToKittingStationTriggered = false;
     }
@@ -1041,111 +1255,8 @@ void ROSAGVPlugin::OnUpdate(const common::UpdateInfo &_info)
             lock_msg.set_data("lock");
             this->dataPtr->lockTrayModelsPub->Publish(lock_msg);
 
-            //--select animation based on the name of the station
-
-            std::string current_station{};
-            if (this->dataPtr->agvName == "agv1")
-            {
-                // ROS_INFO_STREAM("AGV1");
-                this->dataPtr->rosnode->getParam(this->dataPtr->agv1Param, current_station);
-            }
-            else if (this->dataPtr->agvName == "agv2")
-            {
-                // ROS_INFO_STREAM("AGV2");
-                this->dataPtr->rosnode->getParam(this->dataPtr->agv2Param, current_station);
-            }
-            else if (this->dataPtr->agvName == "agv3")
-            {
-                // ROS_INFO_STREAM("AGV3");
-                this->dataPtr->rosnode->getParam(this->dataPtr->agv3Param, current_station);
-            }
-            else if (this->dataPtr->agvName == "agv4")
-            {
-                // ROS_INFO_STREAM("AGV4");
-                this->dataPtr->rosnode->getParam(this->dataPtr->agv4Param, current_station);
-            }
-
-            //--Going from KS to AS
-            if (current_station == "KS1" || current_station == "KS2" || current_station == "KS3" || current_station == "KS4")
-            {
-                if (this->dataPtr->assemblyStationName == "AS1" || this->dataPtr->assemblyStationName == "AS4")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->KS_to_AS1AS4_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->KS_to_AS1AS4_animation);
-                    this->dataPtr->currentState = "KS_AS1AS4";
-                }
-                else if (this->dataPtr->assemblyStationName == "AS2" || this->dataPtr->assemblyStationName == "AS5")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->KS_to_AS2AS5_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->KS_to_AS2AS5_animation);
-                    this->dataPtr->currentState = "KS_AS2AS5";
-                }
-                else if (this->dataPtr->assemblyStationName == "AS3" || this->dataPtr->assemblyStationName == "AS6")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->KS_to_AS3AS6_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->KS_to_AS3AS6_animation);
-                    this->dataPtr->currentState = "KS_AS3AS6";
-                }
-            }
-
-            //--Going from AS1/AS4 to other stations
-            if (current_station == "AS1" || current_station == "AS4")
-            {
-                if (this->dataPtr->assemblyStationName == "AS2" || this->dataPtr->assemblyStationName == "AS5")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->AS1AS4_to_AS2AS5_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->AS1AS4_to_AS2AS5_animation);
-                    this->dataPtr->currentState = "AS1AS4_AS2AS5";
-                }
-                else if (this->dataPtr->assemblyStationName == "AS3" || this->dataPtr->assemblyStationName == "AS6")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->AS1AS4_to_AS3AS6_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->AS1AS4_to_AS3AS6_animation);
-                    this->dataPtr->currentState = "AS1AS4_AS3AS6";
-                }
-            }
-
-            //--Going from AS2/AS5 to other stations
-            if (current_station == "AS2" || current_station == "AS5")
-            {
-                if (this->dataPtr->assemblyStationName == "AS1" || this->dataPtr->assemblyStationName == "AS4")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->AS2AS5_to_AS1AS4_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->AS2AS5_to_AS1AS4_animation);
-                    this->dataPtr->currentState = "AS2AS5_AS1AS4";
-                }
-                else if (this->dataPtr->assemblyStationName == "AS3" || this->dataPtr->assemblyStationName == "AS6")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->AS2AS5_to_AS3AS6_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->AS2AS5_to_AS3AS6_animation);
-                    this->dataPtr->currentState = "AS2AS5_AS3AS6";
-                }
-            }
-            //--Going from AS3/AS6 to other stations
-            if (current_station == "AS3" || current_station == "AS6")
-            {
-                if (this->dataPtr->assemblyStationName == "AS1" || this->dataPtr->assemblyStationName == "AS4")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->AS3AS6_to_AS1AS4_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->AS3AS6_to_AS1AS4_animation);
-                    this->dataPtr->currentState = "AS3AS6_AS1AS4";
-                }
-                else if (this->dataPtr->assemblyStationName == "AS2" || this->dataPtr->assemblyStationName == "AS5")
-                {
-                    // ROS_INFO_STREAM("Current station: " << current_station);
-                    this->dataPtr->AS3AS6_to_AS2AS5_animation->SetTime(0);
-                    this->dataPtr->model->SetAnimation(this->dataPtr->AS3AS6_to_AS2AS5_animation);
-                    this->dataPtr->currentState = "AS3AS6_AS2AS5";
-                }
-            }
+            //--select animation based on the current station of the AGV
+            this->StartMove(this->dataPtr->assemblyStationName, currentSimTime);
         }
     }
 
@@ -1170,174 +1281,18 @@ void ROSAGVPlugin::OnUpdate(const common::UpdateInfo &_info)
             lock_msg.set_data("lock");
             this->dataPtr->lockTrayModelsPub->Publish(lock_msg);
 
-            //--Get the current location of the AGV from the parameter server
-            //--This is necessary to choose from predefined paths
-            std::string current_station{};
-            if (this->dataPtr->agvName == "agv1")
-                this->dataPtr->rosnode->getParam(this->dataPtr->agv1Param, current_station);
-
-            if (this->dataPtr->agvName == "agv2")
-                this->dataPtr->rosnode->getParam(this->dataPtr->agv2Param, current_station);
-
-            if (this->dataPtr->agvName == "agv3")
-                this->dataPtr->rosnode->getParam(this->dataPtr->agv3Param, current_station);
-
-            if (this->dataPtr->agvName == "agv4")
-                this->dataPtr->rosnode->getParam(this->dataPtr->agv4Param, current_station);
-
-            if (current_station == "AS1" || current_station == "AS4")
-            {
-                this->dataPtr->AS1AS4_to_KS_animation->SetTime(0);
-                this->dataPtr->model->SetAnimation(this->dataPtr->AS1AS4_to_KS_animation);
-                this->dataPtr->currentState = "AS1AS4_KS";
-            }
-            else if (current_station == "AS2" || current_station == "AS5")
-            {
-                this->dataPtr->AS2AS5_to_KS_animation->SetTime(0);
-                this->dataPtr->model->SetAnimation(this->dataPtr->AS2AS5_to_KS_animation);
-                this->dataPtr->currentState = "AS2AS5_KS";
-            }
-            else if (current_station == "AS3" || current_station == "AS6")
-            {
-                this->dataPtr->AS3AS6_to_KS_animation->SetTime(0);
-                this->dataPtr->model->SetAnimation(this->dataPtr->AS3AS6_to_KS_animation);
-                this->dataPtr->currentState = "AS3AS6_KS";
-            }
+            //--Choose from predefined paths based on the current station of the AGV
+            this->StartMove(this->dataPtr->kittingStationName, currentSimTime);
             ROS_INFO_STREAM("AGV is en route to Kiting Station.");
         }
     }
 
-    //--Current state: KS_AS1AS4
-    if (this->dataPtr->currentState == "KS_AS1AS4")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->KS_to_AS1AS4_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToAS1AnimationDone = this->dataPtr->KS_to_AS1AS4_animation->GetTime() >=
-                                    this->dataPtr->KS_to_AS1AS4_animation->GetLength();
-        if (goToAS1AnimationDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
-
-    //--Current state: KS_AS2AS5
-    if (this->dataPtr->currentState == "KS_AS2AS5")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->KS_to_AS2AS5_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToAS2AnimationDone = this->dataPtr->KS_to_AS2AS5_animation->GetTime() >=
-                                    this->dataPtr->KS_to_AS2AS5_animation->GetLength();
-        if (goToAS2AnimationDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
-
-    //--Current state: KS_AS3AS6
-    if (this->dataPtr->currentState == "KS_AS3AS6")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->KS_to_AS3AS6_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToAS3AnimationDone = this->dataPtr->KS_to_AS3AS6_animation->GetTime() >=
-                                    this->dataPtr->KS_to_AS3AS6_animation->GetLength();
-        if (goToAS3AnimationDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
-
-    //--Current state: AS1AS4_AS2AS5
-    if (this->dataPtr->currentState == "AS1AS4_AS2AS5")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS1AS4_to_AS2AS5_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToDone = this->dataPtr->AS1AS4_to_AS2AS5_animation->GetTime() >=
-                        this->dataPtr->AS1AS4_to_AS2AS5_animation->GetLength();
-        if (goToDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
-
-    //--Current state: AS1AS4_AS3AS6
-    if (this->dataPtr->currentState == "AS1AS4_AS3AS6")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS1AS4_to_AS3AS6_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToDone = this->dataPtr->AS1AS4_to_AS3AS6_animation->GetTime() >=
-                        this->dataPtr->AS1AS4_to_AS3AS6_animation->GetLength();
-        if (goToDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
-
-    //--Current state: AS2AS5_AS1AS4
-    if (this->dataPtr->currentState == "AS2AS5_AS1AS4")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS2AS5_to_AS1AS4_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToDone = this->dataPtr->AS2AS5_to_AS1AS4_animation->GetTime() >=
-                        this->dataPtr->AS2AS5_to_AS1AS4_animation->GetLength();
-        if (goToDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
-
-    //--Current state: AS2AS5_AS3AS6
-    if (this->dataPtr->currentState == "AS2AS5_AS3AS6")
+    //--Current state: moving between two stations (KS_AS1AS4, AS2AS5_KS, ...)
+    if (this->dataPtr->moving)
     {
+        double elapsed = this->dataPtr->ElapsedMoveTime(currentSimTime);
         // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS2AS5_to_AS3AS6_animation->GetTime() >= 0.5)
+        if (!this->dataPtr->gravityDisabled && elapsed >= 0.5)
         {
             // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
             gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
@@ -1345,117 +1300,18 @@ void ROSAGVPlugin::OnUpdate(const common::UpdateInfo &_info)
             this->dataPtr->model->SetGravityMode(false);
             this->dataPtr->gravityDisabled = true;
         }
-        bool goToDone = this->dataPtr->AS2AS5_to_AS3AS6_animation->GetTime() >=
-                        this->dataPtr->AS2AS5_to_AS3AS6_animation->GetLength();
-        if (goToDone)
+        if (elapsed >= this->dataPtr->activeAnimation->GetLength())
         {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
+            //--In fast mode the AGV did not move yet
+            if (this->dataPtr->fastMode)
+                this->TeleportToEndOfMove();
 
-    //--Current state: AS3AS6_AS1AS4
-    if (this->dataPtr->currentState == "AS3AS6_AS1AS4")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS3AS6_to_AS1AS4_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToDone = this->dataPtr->AS3AS6_to_AS1AS4_animation->GetTime() >=
-                        this->dataPtr->AS3AS6_to_AS1AS4_animation->GetLength();
-        if (goToDone)
-        {
             gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
-
-    //--Current state: AS3AS6_AS2AS5
-    if (this->dataPtr->currentState == "AS3AS6_AS2AS5")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS3AS6_to_AS2AS5_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToDone = this->dataPtr->AS3AS6_to_AS2AS5_animation->GetTime() >=
-                        this->dataPtr->AS3AS6_to_AS2AS5_animation->GetLength();
-        if (goToDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_station";
-        }
-    }
-
-    //--Current state: AS1AS4_KS
-    if (this->dataPtr->currentState == "AS1AS4_KS")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS1AS4_to_KS_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToDone = this->dataPtr->AS1AS4_to_KS_animation->GetTime() >=
-                        this->dataPtr->AS1AS4_to_KS_animation->GetLength();
-        if (goToDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_kitting_station";
-        }
-    }
-
-    //--Current state: AS2AS5_KS
-    if (this->dataPtr->currentState == "AS2AS5_KS")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS2AS5_to_KS_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToDone = this->dataPtr->AS2AS5_to_KS_animation->GetTime() >=
-                        this->dataPtr->AS2AS5_to_KS_animation->GetLength();
-        if (goToDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_kitting_station";
-        }
-    }
-
-    //--Current state: AS3AS6_KS
-    if (this->dataPtr->currentState == "AS3AS6_KS")
-    {
-        // Wait until AGV is away from potential user interference
-        if (!this->dataPtr->gravityDisabled && this->dataPtr->AS3AS6_to_KS_animation->GetTime() >= 0.5)
-        {
-            // Parts will fall through the tray during the animation unless gravity is disabled on the AGV
-            gzdbg << "Disabling gravity on model: " << this->dataPtr->agvName << std::endl;
-            ROS_INFO_STREAM("Disabling gravity on model: " << this->dataPtr->agvName);
-            this->dataPtr->model->SetGravityMode(false);
-            this->dataPtr->gravityDisabled = true;
-        }
-        bool goToDone = this->dataPtr->AS3AS6_to_KS_animation->GetTime() >=
-                        this->dataPtr->AS3AS6_to_KS_animation->GetLength();
-        if (goToDone)
-        {
-            gzdbg << "Docking animation finished." << std::endl;
-            this->dataPtr->currentState = "docked_to_kitting_station";
+            this->dataPtr->moving = false;
+            if (this->dataPtr->destination == this->dataPtr->kittingStationName)
+                this->dataPtr->currentState = "docked_to_kitting_station";
+            else
+                this->dataPtr->currentState = "docked_to_station";
         }
     }
 
@@ -1485,6 +1341,9 @@ void ROSAGVPlugin::OnUpdate(const common::UpdateInfo &_info)
         {
             this->dataPtr->rosnode->setParam(this->dataPtr->agv4Param, this->dataPtr->assemblyStationName);
         }
+        this->dataPtr->station = this->dataPtr->assemblyStationName;
+        this->dataPtr->activeAnimation.reset();
+        this->PublishTelemetry(currentSimTime, true);
         // std::string agvLocation = this->dataPtr->agvName + "_station";
         // this->dataPtr->rosnode->setParam(agvLocation, this->dataPtr->assemblyStationName);
 
@@ -1511,6 +1370,9 @@ void ROSAGVPlugin::OnUpdate(const common::UpdateInfo &_info)
             this->dataPtr->rosnode->setParam(this->dataPtr->agv3Param, "KS3");
         else if (this->dataPtr->agvName == "agv4")
             this->dataPtr->rosnode->setParam(this->dataPtr->agv4Param, "KS4");
+        this->dataPtr->station = this->dataPtr->kittingStationName;
+        this->dataPtr->activeAnimation.reset();
+        this->PublishTelemetry(currentSimTime, true);
 
         // std::string agvLocation = this->dataPtr->agvName + "_station";
         // this->dataPtr->rosnode->setParam(agvLocation, this->dataPtr->assemblyStationName);
@@ -1593,6 +1455,130 @@ void ROSAGVPlugin::OnUpdate(const common::UpdateInfo &_info)
     std_msgs::String stateMsg;
     stateMsg.data = this->dataPtr->currentState;
     this->dataPtr->statePub.publish(stateMsg);
+
+    if (this->dataPtr->telemetryPeriod > 0 &&
+        currentSimTime - this->dataPtr->lastTelemetryTime >= this->dataPtr->telemetryPeriod)
+    {
+        this->PublishTelemetry(currentSimTime, false);
+    }
+}
+
+/////////////////////////////////////////////////
+void ROSAGVPlugin::StartMove(const std::string &_destination, const common::Time &_time)
+{
+    //--Get the current location of the AGV from the parameter server
+    std::string parameter = "/ariac/" + this->dataPtr->agvName + "_station";
+    this->dataPtr->rosnode->getParam(parameter, this->dataPtr->station);
+
+    int from = ariac::AGVLaneNode(this->dataPtr->station);
+    int to = ariac::AGVLaneNode(_destination);
+    if (from < 0 || to < 0 || !this->dataPtr->moveAnimations[from][to])
+    {
+        ROS_ERROR_STREAM("[" << this->dataPtr->agvName << "] No path from " << this->dataPtr->station
+                             << " to " << _destination);
+        this->dataPtr->currentState = "ready_to_deliver";
+        return;
+    }
+
+    static const std::string nodeNames[4] = {"KS", "AS1AS4", "AS2AS5", "AS3AS6"};
+    this->dataPtr->activeAnimation = this->dataPtr->moveAnimations[from][to];
+    this->dataPtr->activeAnimation->SetTime(0);
+    //--In fast mode the AGV is only moved once the travel time has elapsed
+    if (!this->dataPtr->fastMode)
+        this->dataPtr->model->SetAnimation(this->dataPtr->activeAnimation);
+    this->dataPtr->moving = true;
+    this->dataPtr->moveStartTime = _time;
+    this->dataPtr->currentState = nodeNames[from] + "_" + nodeNames[to];
+    this->dataPtr->destination = _destination;
+    this->dataPtr->eta = _time + this->dataPtr->activeAnimation->GetLength();
+}
+
+/////////////////////////////////////////////////
+void ROSAGVPlugin::TeleportToEndOfMove()
+{
+    auto animation = this->dataPtr->activeAnimation;
+    auto lastKey = static_cast<common::PoseKeyFrame *>(
+        animation->GetKeyFrame(animation->GetKeyFrameCount() - 1));
+    ignition::math::Pose3d target(lastKey->Translation(), lastKey->Rotation());
+    ignition::math::Pose3d agvPose = this->dataPtr->model->WorldPose();
+
+    //--Collect the tray and the parts locked to it (attached with fixed joints to the tray link)
+    //--before moving anything, so each of them keeps its pose relative to the AGV.
+    std::vector<std::pair<physics::ModelPtr, ignition::math::Pose3d>> carried;
+    if (!this->dataPtr->trayLink)
+    {
+        this->dataPtr->trayLink = boost::dynamic_pointer_cast<physics::Link>(
+            this->dataPtr->world->EntityByName(this->dataPtr->trayLinkName));
+    }
+    if (this->dataPtr->trayLink)
+    {
+        auto trayModel = this->dataPtr->trayLink->GetModel();
+        carried.push_back({trayModel, trayModel->WorldPose() - agvPose});
+        for (const auto &joint : this->dataPtr->trayLink->GetParentJoints())
+        {
+            if (joint->GetName().find("__joint__") == std::string::npos || !joint->GetParent())
+                continue;
+            auto part = joint->GetParent()->GetModel();
+            carried.push_back({part, part->WorldPose() - agvPose});
+        }
+    }
+
+    this->dataPtr->model->SetWorldPose(target);
+    for (auto &entry : carried)
+        entry.first->SetWorldPose(entry.second + target);
+}
+
+/////////////////////////////////////////////////
+void ROSAGVPlugin::PublishTelemetry(const common::Time &_time, bool _arrived)
+{
+    this->dataPtr->lastTelemetryTime = _time;
+    if (this->dataPtr->telemetryPub.getNumSubscribers() == 0)
+        return;
+
+    nist_gear::AGVTelemetry msg;
+    msg.agv_name = this->dataPtr->agvName;
+    msg.state = this->dataPtr->currentState;
+    msg.from_station = this->dataPtr->station;
+    msg.arrived = _arrived;
+
+    if (this->dataPtr->currentState == "ready_to_deliver")
+    {
+        msg.to_station = this->dataPtr->station;
+        msg.progress = 1.0;
+        msg.eta = ros::Time(_time.sec, _time.nsec);
+    }
+    else
+    {
+        msg.to_station = this->dataPtr->destination;
+        msg.progress = 0.0;
+        if (this->dataPtr->moving && this->dataPtr->activeAnimation->GetLength() > 0)
+        {
+            msg.progress = std::min(1.0, this->dataPtr->ElapsedMoveTime(_time) /
+                                             this->dataPtr->activeAnimation->GetLength());
+        }
+        msg.eta = ros::Time(this->dataPtr->eta.sec, this->dataPtr->eta.nsec);
+    }
+
+    //--Parts locked to the tray are attached with a fixed joint to the tray link
+    if (!this->dataPtr->trayLink)
+    {
+        this->dataPtr->trayLink = boost::dynamic_pointer_cast<physics::Link>(
+            this->dataPtr->world->EntityByName(this->dataPtr->trayLinkName));
+    }
+    msg.tray_locked = false;
+    if (this->dataPtr->trayLink)
+    {
+        for (const auto &joint : this->dataPtr->trayLink->GetParentJoints())
+        {
+            if (joint->GetName().find("__joint__") != std::string::npos)
+            {
+                msg.tray_locked = true;
+                break;
+            }
+        }
+    }
+
+    this->dataPtr->telemetryPub.publish(msg);
 }
 
 /////////////////////////////////////////////////
@@ -1928,4 +1914,44 @@ bool ROSAGVPlugin::OnCommandToKittingStation(
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+/////////////////////////////////////////////////
+void ROSAGVPlugin::OnDispatchRequest(ConstGzStringPtr &_msg)
+{
+    const std::string &station = _msg->data();
+
+    std::string current_station;
+    std::string parameter = "/ariac/" + this->dataPtr->agvName + "_station";
+    this->dataPtr->rosnode->getParam(parameter, current_station);
+
+    if (this->dataPtr->currentState != "ready_to_deliver")
+    {
+        ROS_ERROR_STREAM("[" << this->dataPtr->agvName << "->" << station
+                             << "] FAILURE: dispatch ignored, AGV is not ready.");
+        return;
+    }
+
+    if (station.compare(0, 2, "KS") == 0)
+    {
+        if (current_station.find("KS") != std::string::npos)
+        {
+            ROS_ERROR_STREAM("[" << this->dataPtr->agvName
+                                 << " already at kitting station] FAILURE: dispatch ignored.");
+            return;
+        }
+        this->dataPtr->goToKittingStationTriggered = true;
+    }
+    else
+    {
+        if (current_station == station)
+        {
+            ROS_ERROR_STREAM("[" << this->dataPtr->agvName << " already at station: " << station
+                                 << "] FAILURE: dispatch ignored.");
+            return;
+        }
+        this->dataPtr->assemblyStationName = station;
+        this->dataPtr->goToAssemblyStationTriggered = true;
+    }
+    ROS_INFO_STREAM("[" << this->dataPtr->agvName << "->" << station << "] SUCCESS: AGV dispatched.");
+}
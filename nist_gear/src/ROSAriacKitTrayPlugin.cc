@@ -15,6 +15,8 @@
  *
 */
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <string>
 
@@ -55,7 +57,7 @@ void KitTrayPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
         std::string faultyPartName = faultyPartElem->Get<std::string>();
 
         ROS_DEBUG_STREAM("Ignoring part: " << faultyPartName);
-        this->faultyPartNames.push_back(faultyPartName);
+        this->faultyPartNames.insert(faultyPartName);
         faultyPartElem = faultyPartElem->GetNextElement("name");
       }
     }
@@ -82,6 +84,27 @@ void KitTrayPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
     "/ariac/trays", 1000, boost::bind(&KitTrayPlugin::OnSubscriberConnect, this, _1));
   this->publishingEnabled = true;
 
+  // Products added, removed or moved on the tray. Unlike /ariac/trays,
+  // subscribing is allowed, but during the competition the events leave out
+  // the faulty flags and the poses of the products.
+  this->hideContentDetails = std::getenv("ARIAC_COMPETITION") != nullptr;
+  std::string contentEventsTopic = "/ariac/trays/events";
+  if (_sdf->HasElement("content_events_topic"))
+    contentEventsTopic = _sdf->Get<std::string>("content_events_topic");
+  this->contentEventsPub = this->rosNode->advertise<nist_gear::TrayContentEvents>(
+    contentEventsTopic, 1000);
+
+  // The kit is only published when it changes, plus a low rate keepalive
+  if (_sdf->HasElement("publish_position_tolerance"))
+    this->publishPositionTolerance = _sdf->Get<double>("publish_position_tolerance");
+  if (_sdf->HasElement("publish_orientation_tolerance"))
+    this->publishOrientationTolerance = _sdf->Get<double>("publish_orientation_tolerance");
+  if (_sdf->HasElement("keepalive_rate"))
+  {
+    double keepaliveRate = _sdf->Get<double>("keepalive_rate");
+    this->keepalivePeriod = keepaliveRate > 0 ? 1.0 / keepaliveRate : 0.0;
+  }
+
   this->tf_frame_name = "kit_tray_frame";
   if (_sdf->HasElement("tf_frame_name"))
     this->tf_frame_name = _sdf->Get<std::string>("tf_frame_name");
@@ -100,6 +123,13 @@ void KitTrayPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
   this->trayContentsServer =
     this->rosNode->advertiseService(contentServiceName, &KitTrayPlugin::HandleGetContentService, this);
 
+  // ROS service for requesting a snapshot of the content events
+  std::string resyncServiceName = "resync_content_events";
+  if (_sdf->HasElement("resync_content_events_service_name"))
+    resyncServiceName = _sdf->Get<std::string>("resync_content_events_service_name");
+  this->resyncEventsServer =
+    this->rosNode->advertiseService(resyncServiceName, &KitTrayPlugin::HandleResyncEventsService, this);
+
   // Initialize Gazebo transport
   this->gzNode = transport::NodePtr(new transport::Node());
   this->gzNode->Init();
@@ -127,6 +157,13 @@ void KitTrayPlugin::OnUpdate(const common::UpdateInfo & _info)
 
   if (!this->newMsg)
   {
+    // Nothing new on the tray, but listeners still get the keepalive
+    if (this->publishingEnabled)
+    {
+      this->PublishKitMsg(_info.simTime);
+      if (this->resyncRequested)
+        this->PublishContentEvents();
+    }
     return;
   }
 
@@ -154,7 +191,8 @@ void KitTrayPlugin::OnUpdate(const common::UpdateInfo & _info)
   this->ProcessContactingModels();
   if (this->publishingEnabled)
   {
-    this->PublishKitMsg();
+    this->PublishKitMsg(_info.simTime);
+    this->PublishContentEvents();
   }
   this->PublishTFTransform(_info.simTime);
 }
@@ -171,30 +209,59 @@ void KitTrayPlugin::ProcessContactingModels()
     this->contactingModels.insert(link->GetParentModel());
   }
   this->currentKit.objects.clear();
+
+  // Every cached pose is relative to the tray, so they are all stale if it
+  // moved. Simulated contacts jitter, so moves within the publication
+  // tolerances are ignored.
   auto trayPose = this->parentLink->WorldPose();
+  if (this->kitObjectCache.empty() || this->PoseMoved(trayPose, this->cachedTrayPose))
+  {
+    this->kitObjectCache.clear();
+    this->cachedTrayPose = trayPose;
+    this->cachedTrayInverse = ignition::math::Matrix4d(trayPose).Inverse();
+  }
+
+  // Entries of models that left the tray are not carried over
+  std::unordered_map<std::string, CachedKitObject> kitObjects;
+  kitObjects.reserve(this->contactingModels.size());
   for (auto model : this->contactingModels) {
     if (model) {
       model->SetAutoDisable(false);
-      ariac::KitObject object;
+      const std::string &scopedName = model->GetScopedName();
+      ignition::math::Pose3d objectPose = model->WorldPose();
+
+      auto cached = this->kitObjectCache.find(scopedName);
+      if (cached != this->kitObjectCache.end() &&
+          !this->PoseMoved(objectPose, cached->second.modelWorldPose))
+      {
+        this->currentKit.objects.push_back(cached->second.object);
+        kitObjects.emplace(scopedName, std::move(cached->second));
+        continue;
+      }
+
+      CachedKitObject entry;
+      entry.modelWorldPose = objectPose;
+      entry.modelId = model->GetId();
+      entry.modelName = scopedName;
+      ariac::KitObject &object = entry.object;
 
       // Determine the object type
       object.type = ariac::DetermineModelType(model->GetName());
 
       // Determine if the object is faulty
       auto modelName = ariac::TrimNamespace(model->GetName());
-      auto it = std::find(this->faultyPartNames.begin(), this->faultyPartNames.end(), modelName);
-      object.isFaulty = it != this->faultyPartNames.end();
+      object.isFaulty = this->faultyPartNames.count(modelName) > 0;
 
       // Determine the pose of the object in the frame of the tray
-      ignition::math::Pose3d objectPose = model->WorldPose();
-      ignition::math::Matrix4d transMat(trayPose);
       ignition::math::Matrix4d objectPoseMat(objectPose);
-      object.pose = (transMat.Inverse() * objectPoseMat).Pose();
+      object.pose = (this->cachedTrayInverse * objectPoseMat).Pose();
       object.pose.Rot().Normalize();
 
       this->currentKit.objects.push_back(object);
+      kitObjects.emplace(scopedName, std::move(entry));
     }
   }
+  this->kitObjectCache.swap(kitObjects);
 }
 
 /////////////////////////////////////////////////
@@ -217,11 +284,144 @@ void KitTrayPlugin::OnSubscriberConnect(const ros::SingleSubscriberPublisher& pu
 }
 
 /////////////////////////////////////////////////
-void KitTrayPlugin::PublishKitMsg()
+bool KitTrayPlugin::KitChangedSincePublished() const
 {
+  if (!this->kitPublished)
+    return true;
+
+  const auto &current = this->currentKit.objects;
+  const auto &published = this->publishedKit.objects;
+  if (current.size() != published.size())
+    return true;
+
+  // Models are processed in the same order as long as the set of contacting
+  // models doesn't change, so products can be compared one by one.
+  for (size_t i = 0; i < current.size(); ++i)
+  {
+    if (current[i].type != published[i].type || current[i].isFaulty != published[i].isFaulty)
+      return true;
+    if (this->ObjectMoved(current[i], published[i]))
+      return true;
+  }
+  return false;
+}
+
+/////////////////////////////////////////////////
+bool KitTrayPlugin::ObjectMoved(const ariac::KitObject &_a, const ariac::KitObject &_b) const
+{
+  return this->PoseMoved(_a.pose, _b.pose);
+}
+
+/////////////////////////////////////////////////
+bool KitTrayPlugin::PoseMoved(const ignition::math::Pose3d &_a,
+                              const ignition::math::Pose3d &_b) const
+{
+  if (_a.Pos().Distance(_b.Pos()) > this->publishPositionTolerance)
+    return true;
+  double dot = std::abs(_a.Rot().Dot(_b.Rot()));
+  double angle = 2.0 * std::acos(std::min(1.0, dot));
+  return angle > this->publishOrientationTolerance;
+}
+
+/////////////////////////////////////////////////
+static geometry_msgs::Pose PoseToMsg(const ignition::math::Pose3d &_pose)
+{
+  geometry_msgs::Pose msg;
+  msg.position.x = _pose.Pos().X();
+  msg.position.y = _pose.Pos().Y();
+  msg.position.z = _pose.Pos().Z();
+  msg.orientation.x = _pose.Rot().X();
+  msg.orientation.y = _pose.Rot().Y();
+  msg.orientation.z = _pose.Rot().Z();
+  msg.orientation.w = _pose.Rot().W();
+  return msg;
+}
+
+/////////////////////////////////////////////////
+void KitTrayPlugin::PublishContentEvents()
+{
+  nist_gear::TrayContentEvents eventsMsg;
+  bool hideDetails = this->hideContentDetails;
+  auto addDelta = [&eventsMsg, hideDetails](uint8_t _event, const CachedKitObject &_entry)
+  {
+    nist_gear::TrayContentDelta delta;
+    delta.event = _event;
+    delta.model_id = _entry.modelId;
+    delta.model_name = _entry.modelName;
+    delta.type = _entry.object.type;
+    if (!hideDetails)
+    {
+      delta.is_faulty = _entry.object.isFaulty;
+      delta.pose = PoseToMsg(_entry.object.pose);
+    }
+    eventsMsg.deltas.push_back(delta);
+  };
+
+  // The cache holds exactly the models currently on the tray
+  std::unordered_map<uint32_t, CachedKitObject> current;
+  current.reserve(this->kitObjectCache.size());
+  for (const auto &cached : this->kitObjectCache)
+    current.emplace(cached.second.modelId, cached.second);
+
+  eventsMsg.snapshot = this->resyncRequested.exchange(false);
+  if (eventsMsg.snapshot)
+  {
+    for (const auto &entry : current)
+      addDelta(nist_gear::TrayContentDelta::ADDED, entry.second);
+    this->announcedObjects = current;
+  }
+  else
+  {
+    for (auto it = this->announcedObjects.begin(); it != this->announcedObjects.end();)
+    {
+      if (current.count(it->first) == 0)
+      {
+        addDelta(nist_gear::TrayContentDelta::REMOVED, it->second);
+        it = this->announcedObjects.erase(it);
+      }
+      else
+        ++it;
+    }
+    for (const auto &entry : current)
+    {
+      auto announced = this->announcedObjects.find(entry.first);
+      if (announced == this->announcedObjects.end())
+      {
+        addDelta(nist_gear::TrayContentDelta::ADDED, entry.second);
+        this->announcedObjects.emplace(entry.first, entry.second);
+      }
+      else if (this->ObjectMoved(entry.second.object, announced->second.object))
+      {
+        // Small moves accumulate until they exceed the tolerances
+        addDelta(nist_gear::TrayContentDelta::MOVED, entry.second);
+        announced->second = entry.second;
+      }
+    }
+    if (eventsMsg.deltas.empty())
+      return;
+  }
+
+  eventsMsg.destination_id = this->trayID;
+  eventsMsg.sequence = ++this->contentEventsSequence;
+  this->contentEventsPub.publish(eventsMsg);
+}
+
+/////////////////////////////////////////////////
+void KitTrayPlugin::PublishKitMsg(const common::Time &_simTime)
+{
+  bool keepaliveDue = this->keepalivePeriod > 0 &&
+    (_simTime - this->lastKitPublishTime).Double() >= this->keepalivePeriod;
+  if (!keepaliveDue && !this->KitChangedSincePublished())
+    return;
+
+  this->publishedKit = this->currentKit;
+  this->kitPublished = true;
+  this->lastKitPublishTime = _simTime;
+
   // Publish current kit
   nist_gear::DetectedShipment kitTrayMsg;
   kitTrayMsg.destination_id = this->trayID;
+  kitTrayMsg.sequence = ++this->kitSequence;
   // ROS_INFO_STREAM(kitTrayMsg.destination_id);
   for (const auto &obj : this->currentKit.objects)
   {
@@ -376,6 +576,32 @@ bool KitTrayPlugin::HandleGetContentService(
   return true;
 }
 
+/////////////////////////////////////////////////
+bool KitTrayPlugin::HandleResyncEventsService(
+  ros::ServiceEvent<std_srvs::Trigger::Request, std_srvs::Trigger::Response>& event)
+{
+  std_srvs::Trigger::Response& res = event.getResponse();
+
+  const std::string& callerName = event.getCallerName();
+  gzdbg << this->trayID << ": Handle resync content events service called by: " << callerName << std::endl;
+
+  // During the competition, this environment variable will be set.
+  auto compRunning = std::getenv("ARIAC_COMPETITION");
+  if (compRunning && callerName.compare("/gazebo") != 0)
+  {
+    std::string errStr = "Competition is running so this service is not enabled.";
+    gzerr << errStr << std::endl;
+    ROS_ERROR_STREAM(errStr);
+    res.success = false;
+    return true;
+  }
+
+  // The snapshot is published by the next update
+  this->resyncRequested = true;
+  res.success = true;
+  return true;
+}
+
 void KitTrayPlugin::PublishTFTransform(const common::Time sim_time)
 {
   ignition::math::Pose3d objectPose = this->tray_pose;
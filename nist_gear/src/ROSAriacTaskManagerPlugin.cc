@@ -44,6 +44,7 @@
 #include "nist_gear/ARIAC.hh"
 #include "nist_gear/ROSAriacTaskManagerPlugin.hh"
 #include "nist_gear/AriacScorer.h"
+#include "nist_gear/ContactDispatcher.hh"
 #include "nist_gear/ConveyorBeltControl.h"
 #include "nist_gear/DetectShipment.h"
 #include "nist_gear/KittingShipment.h"
@@ -255,6 +256,10 @@ namespace gazebo
   public:
     transport::SubscriberPtr contactSub;
 
+    /// \brief Id of the ContactDispatcher listener, 0 when subscribed to the contact topic
+  public:
+    unsigned int contactListenerId = 0;
+
   public:
     const std::vector<std::string> gantry_collision_filter_vec{
         "base_link_collision", "shoulder_link_collision", "upper_arm_link_collision",
@@ -338,6 +343,8 @@ ROSAriacTaskManagerPlugin::ROSAriacTaskManagerPlugin()
 /////////////////////////////////////////////////
 ROSAriacTaskManagerPlugin::~ROSAriacTaskManagerPlugin()
 {
+  if (this->dataPtr->contactListenerId)
+    ContactDispatcher::Instance().Unregister(this->dataPtr->contactListenerId);
   this->dataPtr->rosnode->shutdown();
 }
 
@@ -374,7 +381,16 @@ void ROSAriacTaskManagerPlugin::Load(physics::WorldPtr _world,
   //auto contact_manager = this->dataPtr->world->Physics()->GetContactManager();
   //std::string contactTopic = contact_manager->CreateFilter("AriacTaskManagerFilter", this->dataPtr->collisionFilter);
   //this->dataPtr->contactSub = this->dataPtr->node->Subscribe(contactTopic, &ROSAriacTaskManagerPlugin::OnContactsReceived, this);
-  this->dataPtr->contactSub = this->dataPtr->node->Subscribe("~/physics/contacts", &ROSAriacTaskManagerPlugin::OnContactsReceived, this);
+  // When the contact dispatcher is loaded, contacts are received in-process instead
+  if (ContactDispatcher::Instance().Enabled())
+  {
+    this->dataPtr->contactListenerId = ContactDispatcher::Instance().RegisterAll(
+      std::bind(&ROSAriacTaskManagerPlugin::OnContactRecords, this, std::placeholders::_1));
+  }
+  else
+  {
+    this->dataPtr->contactSub = this->dataPtr->node->Subscribe("~/physics/contacts", &ROSAriacTaskManagerPlugin::OnContactsReceived, this);
+  }
 
   // Initialize ROS
   this->dataPtr->rosnode.reset(new ros::NodeHandle(robotNamespace));
@@ -1671,6 +1687,13 @@ void ROSAriacTaskManagerPlugin::OnShipmentContent(nist_gear::DetectedShipment::C
 {
   // store the shipment content to be used for deciding when to interrupt orders
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  // Ignore messages older than the one already stored (0 means unsequenced)
+  auto it = this->dataPtr->kittingShipmentContents.find(shipment->destination_id);
+  if (it != this->dataPtr->kittingShipmentContents.end() && shipment->sequence != 0 &&
+      it->second->sequence >= shipment->sequence)
+  {
+    return;
+  }
   this->dataPtr->kittingShipmentContents[shipment->destination_id] = shipment;
   // this->dataPtr->kittingShipmentContents[shipment->station_id] = shipment;
 }
@@ -1704,17 +1727,38 @@ void ROSAriacTaskManagerPlugin::OnContactsReceived(ConstContactsPtr &_msg)
     }
     */
 
-    // Simplified arm-arm and arm-torso collision, as all arm and torso links are prefaced with 'gantry::'
-    // e.g. gantry::left_forearm_link::left_forearm_link_collision and gantry::torso_main::torso_main_collision
-    // Also - only check if competition has started, as arm is in collision when first spawned
-    if (this->dataPtr->currentState == "go" &&
-        contact.collision1().rfind("gantry", 0) == 0 &&
-        contact.collision2().rfind("gantry", 0) == 0)
-    {
-      ROS_ERROR_STREAM("arm/arm contact detected: " << contact.collision1() << " and " << contact.collision2());
-      std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
-      common::Time time(contact.time().sec(), contact.time().nsec());
-      this->dataPtr->ariacScorer.NotifyArmArmCollision(time);
-    }
+    common::Time time(contact.time().sec(), contact.time().nsec());
+    this->CheckArmArmContact(contact.collision1(), contact.collision2(), time);
+  }
+}
+
+//////////////////////////////////////////////////
+void ROSAriacTaskManagerPlugin::OnContactRecords(const std::vector<ContactRecord> &_records)
+{
+  // Only check if competition has started, as arm is in collision when first spawned
+  if (this->dataPtr->currentState != "go")
+    return;
+
+  for (const auto &record : _records)
+  {
+    this->CheckArmArmContact(
+      record.collision->GetScopedName(), record.other->GetScopedName(), record.time);
+  }
+}
+
+//////////////////////////////////////////////////
+void ROSAriacTaskManagerPlugin::CheckArmArmContact(
+  const std::string &_collision1, const std::string &_collision2, const common::Time &_time)
+{
+  // Simplified arm-arm and arm-torso collision, as all arm and torso links are prefaced with 'gantry::'
+  // e.g. gantry::left_forearm_link::left_forearm_link_collision and gantry::torso_main::torso_main_collision
+  // Also - only check if competition has started, as arm is in collision when first spawned
+  if (this->dataPtr->currentState == "go" &&
+      _collision1.rfind("gantry", 0) == 0 &&
+      _collision2.rfind("gantry", 0) == 0)
+  {
+    ROS_ERROR_STREAM("arm/arm contact detected: " << _collision1 << " and " << _collision2);
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->ariacScorer.NotifyArmArmCollision(_time);
   }
 }
@@ -24,9 +24,12 @@
 #include "ROSLaserPlugin.hh"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <string>
 #include <assert.h>
 
+#include <ignition/math/Matrix3.hh>
 #include <gazebo/physics/World.hh>
 #include <gazebo/physics/HingeJoint.hh>
 #include <gazebo/sensors/Sensor.hh>
@@ -42,6 +45,31 @@
 
 namespace gazebo
 {
+/// \brief Maximum number of messages kept for reuse
+static const size_t kMaxPooledScans = 4;
+
+/// \brief Get a message of a pool that nobody else holds, or a new one if
+/// they are all still held by subscribers
+template <typename M>
+static boost::shared_ptr<M> NextPooledMsg(
+  std::vector<boost::shared_ptr<M>> &_pool, size_t &_next)
+{
+  for (size_t i = 0; i < _pool.size(); ++i)
+  {
+    size_t index = (_next + i) % _pool.size();
+    if (_pool[index].unique())
+    {
+      _next = (index + 1) % _pool.size();
+      return _pool[index];
+    }
+  }
+
+  boost::shared_ptr<M> msg(new M);
+  if (_pool.size() < kMaxPooledScans)
+    _pool.push_back(msg);
+  return msg;
+}
+
 // Register this plugin with the simulator
 GZ_REGISTER_SENSOR_PLUGIN(ROSLaserPlugin)
 
@@ -98,6 +126,13 @@ void ROSLaserPlugin::Load(sensors::SensorPtr _parent, sdf::ElementPtr _sdf)
   else
     this->topic_name_ = this->sdf->Get<std::string>("topicName");
 
+  // Optional point cloud outputs, computed only while subscribed
+  if (this->sdf->HasElement("pointCloudTopicName"))
+    this->cloud_topic_name_ = this->sdf->Get<std::string>("pointCloudTopicName");
+
+  if (this->sdf->HasElement("worldPointCloudTopicName"))
+    this->world_cloud_topic_name_ = this->sdf->Get<std::string>("worldPointCloudTopicName");
+
   if (_sdf->HasElement("activation_topic"))
   {
     this->activation_topic_name_ = _sdf->Get<std::string>("activation_topic");
@@ -117,8 +152,6 @@ void ROSLaserPlugin::Load(sensors::SensorPtr _parent, sdf::ElementPtr _sdf)
   this->gazebo_node_ = gazebo::transport::NodePtr(new gazebo::transport::Node());
   this->gazebo_node_->Init(this->world_name_);
 
-  this->pmq.startServiceThread();
-
   this->rosnode_ = new ros::NodeHandle(this->robot_namespace_);
 
   this->tf_prefix_ = tf::getPrefixParam(*this->rosnode_);
@@ -141,7 +174,29 @@ void ROSLaserPlugin::Load(sensors::SensorPtr _parent, sdf::ElementPtr _sdf)
       boost::bind(&ROSLaserPlugin::LaserDisconnect, this),
       ros::VoidPtr(), NULL);
     this->pub_ = this->rosnode_->advertise(ao);
-    this->pub_queue_ = this->pmq.addPub<sensor_msgs::LaserScan>();
+  }
+
+  // The clouds are computed from the same scans; any subscriber runs the sensor
+  if (this->cloud_topic_name_ != "")
+  {
+    ros::AdvertiseOptions ao =
+      ros::AdvertiseOptions::create<sensor_msgs::PointCloud2>(
+      this->cloud_topic_name_, 1,
+      boost::bind(&ROSLaserPlugin::LaserConnect, this),
+      boost::bind(&ROSLaserPlugin::LaserDisconnect, this),
+      ros::VoidPtr(), NULL);
+    this->cloud_pub_ = this->rosnode_->advertise(ao);
+  }
+
+  if (this->world_cloud_topic_name_ != "")
+  {
+    ros::AdvertiseOptions ao =
+      ros::AdvertiseOptions::create<sensor_msgs::PointCloud2>(
+      this->world_cloud_topic_name_, 1,
+      boost::bind(&ROSLaserPlugin::LaserConnect, this),
+      boost::bind(&ROSLaserPlugin::LaserDisconnect, this),
+      ros::VoidPtr(), NULL);
+    this->world_cloud_pub_ = this->rosnode_->advertise(ao);
   }
 
   if (this->activation_topic_name_ != "")
@@ -185,27 +240,210 @@ void ROSLaserPlugin::OnScan(ConstLaserScanStampedPtr &_msg)
   {
     return;
   }
+  const msgs::LaserScan &scan = _msg->scan();
+  ros::Time stamp(_msg->time().sec(), _msg->time().nsec());
+
   // We got a new message from the Gazebo sensor.  Stuff a
   // corresponding ROS message and publish it.
-  sensor_msgs::LaserScan laser_msg;
-  laser_msg.header.stamp = ros::Time(_msg->time().sec(), _msg->time().nsec());
-  laser_msg.header.frame_id = this->frame_name_;
-  laser_msg.angle_min = _msg->scan().angle_min();
-  laser_msg.angle_max = _msg->scan().angle_max();
-  laser_msg.angle_increment = _msg->scan().angle_step();
-  laser_msg.time_increment = 0;  // instantaneous simulator scan
-  laser_msg.scan_time = 0;  // not sure whether this is correct
-  laser_msg.range_min = _msg->scan().range_min();
-  laser_msg.range_max = _msg->scan().range_max();
-  laser_msg.ranges.resize(_msg->scan().ranges_size());
-  std::copy(_msg->scan().ranges().begin(),
-            _msg->scan().ranges().end(),
-            laser_msg.ranges.begin());
-  laser_msg.intensities.resize(_msg->scan().intensities_size());
-  std::copy(_msg->scan().intensities().begin(),
-            _msg->scan().intensities().end(),
-            laser_msg.intensities.begin());
-  this->pub_queue_->push(laser_msg, this->pub_);
+  if (this->pub_.getNumSubscribers() > 0)
+  {
+    sensor_msgs::LaserScanPtr laser_msg =
+      NextPooledMsg(this->scan_msgs_, this->next_scan_msg_);
+    laser_msg->header.stamp = stamp;
+    laser_msg->header.frame_id = this->frame_name_;
+    laser_msg->angle_min = scan.angle_min();
+    laser_msg->angle_max = scan.angle_max();
+    laser_msg->angle_increment = scan.angle_step();
+    laser_msg->time_increment = 0;  // instantaneous simulator scan
+    laser_msg->scan_time = 0;  // not sure whether this is correct
+    laser_msg->range_min = scan.range_min();
+    laser_msg->range_max = scan.range_max();
+    // The buffers keep their capacity from one scan to the next
+    laser_msg->ranges.assign(scan.ranges().begin(), scan.ranges().end());
+    if (scan.intensities_size() > 0)
+      laser_msg->intensities.assign(scan.intensities().begin(), scan.intensities().end());
+    else
+      laser_msg->intensities.clear();
+
+    // Intra-process subscribers receive the shared message without
+    // serialization
+    this->pub_.publish(laser_msg);
+  }
+
+  bool sensorCloud = this->cloud_pub_.getNumSubscribers() > 0;
+  bool worldCloud = this->world_cloud_pub_.getNumSubscribers() > 0;
+  if ((!sensorCloud && !worldCloud) || !this->ProjectScan(scan))
+  {
+    return;
+  }
+
+  if (sensorCloud)
+  {
+    sensor_msgs::PointCloud2Ptr cloud =
+      NextPooledMsg(this->cloud_msgs_, this->next_cloud_msg_);
+    this->FillCloud(*cloud, stamp, this->frame_name_,
+      this->ray_count_, this->ray_vertical_count_, nullptr);
+    this->cloud_pub_.publish(cloud);
+  }
+
+  if (worldCloud)
+  {
+    // Pose of the sensor when the scan was taken
+    ignition::math::Pose3d pose = msgs::ConvertIgn(scan.world_pose());
+    sensor_msgs::PointCloud2Ptr cloud =
+      NextPooledMsg(this->world_cloud_msgs_, this->next_world_cloud_msg_);
+    this->FillCloud(*cloud, stamp, "world",
+      this->ray_count_, this->ray_vertical_count_, &pose);
+    this->world_cloud_pub_.publish(cloud);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Compute the direction of every ray
+void ROSLaserPlugin::UpdateRayTable(const msgs::LaserScan &_scan)
+{
+  const unsigned int count = _scan.count();
+  const unsigned int verticalCount = std::max(_scan.vertical_count(), 1u);
+  if (count == this->ray_count_ &&
+      verticalCount == this->ray_vertical_count_ &&
+      _scan.angle_min() == this->ray_angle_min_ &&
+      _scan.angle_step() == this->ray_angle_step_ &&
+      _scan.vertical_angle_min() == this->ray_vertical_angle_min_ &&
+      _scan.vertical_angle_step() == this->ray_vertical_angle_step_)
+  {
+    return;
+  }
+  this->ray_count_ = count;
+  this->ray_vertical_count_ = verticalCount;
+  this->ray_angle_min_ = _scan.angle_min();
+  this->ray_angle_step_ = _scan.angle_step();
+  this->ray_vertical_angle_min_ = _scan.vertical_angle_min();
+  this->ray_vertical_angle_step_ = _scan.vertical_angle_step();
+
+  const size_t size = static_cast<size_t>(count) * verticalCount;
+  this->ray_x_.resize(size);
+  this->ray_y_.resize(size);
+  this->ray_z_.resize(size);
+  this->point_x_.resize(size);
+  this->point_y_.resize(size);
+  this->point_z_.resize(size);
+
+  // The ranges are ordered by vertical angle, then by horizontal angle
+  for (unsigned int j = 0; j < verticalCount; ++j)
+  {
+    const double pitch = this->ray_vertical_angle_min_ + j * this->ray_vertical_angle_step_;
+    const double cosPitch = std::cos(pitch);
+    const double sinPitch = std::sin(pitch);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      const double yaw = this->ray_angle_min_ + i * this->ray_angle_step_;
+      const size_t index = static_cast<size_t>(j) * count + i;
+      this->ray_x_[index] = static_cast<float>(cosPitch * std::cos(yaw));
+      this->ray_y_[index] = static_cast<float>(cosPitch * std::sin(yaw));
+      this->ray_z_[index] = static_cast<float>(sinPitch);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Project the ranges along their rays
+bool ROSLaserPlugin::ProjectScan(const msgs::LaserScan &_scan)
+{
+  this->UpdateRayTable(_scan);
+  const size_t size = this->ray_x_.size();
+  if (static_cast<size_t>(_scan.ranges_size()) != size)
+  {
+    ROS_WARN_THROTTLE_NAMED(1, "laser", "Laser scan has %d ranges, expected %zu",
+      _scan.ranges_size(), size);
+    return false;
+  }
+
+  const double *ranges = _scan.ranges().data();
+  const float *rayX = this->ray_x_.data();
+  const float *rayY = this->ray_y_.data();
+  const float *rayZ = this->ray_z_.data();
+  float *pointX = this->point_x_.data();
+  float *pointY = this->point_y_.data();
+  float *pointZ = this->point_z_.data();
+  const float rangeMin = static_cast<float>(_scan.range_min());
+  const float rangeMax = static_cast<float>(_scan.range_max());
+  const float invalid = std::numeric_limits<float>::quiet_NaN();
+
+  // Branchless so the loop vectorizes; rays that hit nothing give NaN points
+  for (size_t i = 0; i < size; ++i)
+  {
+    const float range = static_cast<float>(ranges[i]);
+    const float r = (range >= rangeMin && range < rangeMax) ? range : invalid;
+    pointX[i] = r * rayX[i];
+    pointY[i] = r * rayY[i];
+    pointZ[i] = r * rayZ[i];
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Write the projected points into a cloud
+void ROSLaserPlugin::FillCloud(sensor_msgs::PointCloud2 &_cloud,
+  const ros::Time &_stamp, const std::string &_frame,
+  unsigned int _width, unsigned int _height,
+  const ignition::math::Pose3d *_pose)
+{
+  _cloud.header.stamp = _stamp;
+  _cloud.header.frame_id = _frame;
+
+  // Organized cloud of x, y, z floats, one point per ray
+  if (_cloud.fields.empty())
+  {
+    const char *names[] = {"x", "y", "z"};
+    _cloud.fields.resize(3);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      _cloud.fields[i].name = names[i];
+      _cloud.fields[i].offset = i * sizeof(float);
+      _cloud.fields[i].datatype = sensor_msgs::PointField::FLOAT32;
+      _cloud.fields[i].count = 1;
+    }
+    _cloud.is_bigendian = false;
+    _cloud.point_step = 3 * sizeof(float);
+  }
+  _cloud.width = _width;
+  _cloud.height = _height;
+  _cloud.row_step = _cloud.point_step * _width;
+  _cloud.is_dense = false;
+  const size_t size = static_cast<size_t>(_width) * _height;
+  _cloud.data.resize(size * _cloud.point_step);
+
+  const float *pointX = this->point_x_.data();
+  const float *pointY = this->point_y_.data();
+  const float *pointZ = this->point_z_.data();
+  float *out = reinterpret_cast<float *>(_cloud.data.data());
+  if (!_pose)
+  {
+    for (size_t i = 0; i < size; ++i)
+    {
+      out[3 * i] = pointX[i];
+      out[3 * i + 1] = pointY[i];
+      out[3 * i + 2] = pointZ[i];
+    }
+    return;
+  }
+
+  const ignition::math::Matrix3d rot(_pose->Rot());
+  const float r00 = rot(0, 0), r01 = rot(0, 1), r02 = rot(0, 2);
+  const float r10 = rot(1, 0), r11 = rot(1, 1), r12 = rot(1, 2);
+  const float r20 = rot(2, 0), r21 = rot(2, 1), r22 = rot(2, 2);
+  const float tx = _pose->Pos().X();
+  const float ty = _pose->Pos().Y();
+  const float tz = _pose->Pos().Z();
+  for (size_t i = 0; i < size; ++i)
+  {
+    const float x = pointX[i];
+    const float y = pointY[i];
+    const float z = pointZ[i];
+    out[3 * i] = r00 * x + r01 * y + r02 * z + tx;
+    out[3 * i + 1] = r10 * x + r11 * y + r12 * z + ty;
+    out[3 * i + 2] = r20 * x + r21 * y + r22 * z + tz;
+  }
 }
 
 /////////////////////////////////////////////////
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/bind.hpp>
+#include <gazebo/common/Assert.hh>
+#include <gazebo/common/Events.hh>
+#include <gazebo/physics/World.hh>
+#include <nist_gear/FusedLogicalCameraImage.h>
+#include <ros/ros.h>
+#include <sdf/sdf.hh>
+
+#include "nist_gear/LogicalCameraAggregator.hh"
+#include "nist_gear/ROSLogicalCameraAggregatorPlugin.hh"
+
+namespace gazebo
+{
+  /// \internal
+  /// \brief Private data for the ROSLogicalCameraAggregatorPlugin class.
+  struct ROSLogicalCameraAggregatorPluginPrivate
+  {
+    /// \brief World pointer.
+  public:
+    physics::WorldPtr world;
+
+    /// \brief ROS node handle.
+  public:
+    std::unique_ptr<ros::NodeHandle> rosnode;
+
+    /// \brief Publisher of the fused detections.
+  public:
+    ros::Publisher fusedPub;
+
+    /// \brief Time between two messages.
+  public:
+    common::Time publishPeriod = common::Time(0.1);
+
+    /// \brief Detections older than this are dropped.
+  public:
+    common::Time maxAge = common::Time(0.5);
+
+    /// \brief Simulation time of the last message.
+  public:
+    common::Time lastPublishTime;
+
+    /// \brief Fused detections, reused from one message to the next.
+  public:
+    std::vector<FusedDetection> fused;
+
+    /// \brief Message published, reused from one message to the next.
+  public:
+    nist_gear::FusedLogicalCameraImage fusedMsg;
+
+    /// \brief Number of subscribers of the topic.
+  public:
+    int subscriberCount = 0;
+
+    /// \brief Protects subscriberCount.
+  public:
+    std::mutex mutex;
+
+    /// \brief Connection to the world update event.
+  public:
+    event::ConnectionPtr updateConnection;
+  };
+}
+
+using namespace gazebo;
+
+GZ_REGISTER_WORLD_PLUGIN(ROSLogicalCameraAggregatorPlugin)
+
+/////////////////////////////////////////////////
+ROSLogicalCameraAggregatorPlugin::ROSLogicalCameraAggregatorPlugin()
+    : dataPtr(new ROSLogicalCameraAggregatorPluginPrivate)
+{
+}
+
+/////////////////////////////////////////////////
+ROSLogicalCameraAggregatorPlugin::~ROSLogicalCameraAggregatorPlugin()
+{
+  if (this->dataPtr->rosnode)
+    this->dataPtr->rosnode->shutdown();
+}
+
+/////////////////////////////////////////////////
+void ROSLogicalCameraAggregatorPlugin::Load(physics::WorldPtr _world,
+                                            sdf::ElementPtr _sdf)
+{
+  GZ_ASSERT(_world, "ROSLogicalCameraAggregatorPlugin world pointer is NULL");
+  GZ_ASSERT(_sdf, "ROSLogicalCameraAggregatorPlugin sdf pointer is NULL");
+  this->dataPtr->world = _world;
+
+  // Make sure the ROS node for Gazebo has already been initialized
+  if (!ros::isInitialized())
+  {
+    ROS_FATAL_STREAM("A ROS node for Gazebo has not been initialized,"
+                     << "unable to load plugin. Load the Gazebo system plugin "
+                     << "'libgazebo_ros_api_plugin.so' in the gazebo_ros package)");
+    return;
+  }
+
+  std::string robotNamespace = "";
+  if (_sdf->HasElement("robot_namespace"))
+    robotNamespace = _sdf->Get<std::string>("robot_namespace") + "/";
+
+  std::string topic = "logical_cameras/fused";
+  if (_sdf->HasElement("topic"))
+    topic = _sdf->Get<std::string>("topic");
+
+  if (_sdf->HasElement("update_rate"))
+  {
+    double updateRate = _sdf->Get<double>("update_rate");
+    this->dataPtr->publishPeriod =
+      updateRate > 0 ? common::Time(1.0 / updateRate) : common::Time::Zero;
+  }
+
+  if (_sdf->HasElement("max_age"))
+    this->dataPtr->maxAge = common::Time(_sdf->Get<double>("max_age"));
+
+  // Initialize ROS
+  this->dataPtr->rosnode.reset(new ros::NodeHandle(robotNamespace));
+  ros::AdvertiseOptions options =
+    ros::AdvertiseOptions::create<nist_gear::FusedLogicalCameraImage>(
+    topic, 1,
+    boost::bind(&ROSLogicalCameraAggregatorPlugin::OnConnect, this),
+    boost::bind(&ROSLogicalCameraAggregatorPlugin::OnDisconnect, this),
+    ros::VoidPtr(), NULL);
+  this->dataPtr->fusedPub = this->dataPtr->rosnode->advertise(options);
+
+  this->dataPtr->updateConnection = event::Events::ConnectWorldUpdateEnd(
+    boost::bind(&ROSLogicalCameraAggregatorPlugin::OnUpdate, this));
+}
+
+/////////////////////////////////////////////////
+void ROSLogicalCameraAggregatorPlugin::OnConnect()
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (++this->dataPtr->subscriberCount == 1)
+    LogicalCameraAggregator::Instance().SetWanted(true);
+}
+
+/////////////////////////////////////////////////
+void ROSLogicalCameraAggregatorPlugin::OnDisconnect()
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (--this->dataPtr->subscriberCount == 0)
+    LogicalCameraAggregator::Instance().SetWanted(false);
+}
+
+/////////////////////////////////////////////////
+void ROSLogicalCameraAggregatorPlugin::OnUpdate()
+{
+  auto &aggregator = LogicalCameraAggregator::Instance();
+  if (!aggregator.Wanted())
+    return;
+
+  common::Time now = this->dataPtr->world->SimTime();
+  if (now - this->dataPtr->lastPublishTime < this->dataPtr->publishPeriod)
+    return;
+  this->dataPtr->lastPublishTime = now;
+
+  aggregator.Fuse(now, this->dataPtr->maxAge, this->dataPtr->fused);
+
+  auto &msg = this->dataPtr->fusedMsg;
+  msg.stamp = ros::Time(now.sec, now.nsec);
+  msg.models.resize(this->dataPtr->fused.size());
+  for (size_t i = 0; i < this->dataPtr->fused.size(); ++i)
+  {
+    const FusedDetection &fused = this->dataPtr->fused[i];
+    const ignition::math::Pose3d &pose = fused.detection.pose;
+    nist_gear::FusedModel &model = msg.models[i];
+    model.name = fused.detection.name;
+    model.type = fused.detection.type;
+    model.pose.position.x = pose.Pos().X();
+    model.pose.position.y = pose.Pos().Y();
+    model.pose.position.z = pose.Pos().Z();
+    model.pose.orientation.x = pose.Rot().X();
+    model.pose.orientation.y = pose.Rot().Y();
+    model.pose.orientation.z = pose.Rot().Z();
+    model.pose.orientation.w = pose.Rot().W();
+    model.stamp = ros::Time(fused.time.sec, fused.time.nsec);
+    model.cameras = fused.cameras;
+  }
+  this->dataPtr->fusedPub.publish(msg);
+}
@@ -18,16 +18,26 @@
 #include "ROSLogicalCameraPlugin.hh"
 
 #include "nist_gear/ARIAC.hh"
+#include "nist_gear/EntityCache.hh"
+#include "nist_gear/LogicalCameraAggregator.hh"
+#include "nist_gear/LogicalPerceptionEngine.hh"
 #include "nist_gear/LogicalCameraImage.h"
 
+#include <gazebo/common/Events.hh>
 #include <gazebo/physics/Link.hh>
 #include <gazebo/physics/Model.hh>
+#include "gazebo/sensors/GaussianNoiseModel.hh"
+#include <gazebo/sensors/LogicalCameraSensor.hh>
 #include "gazebo/sensors/Noise.hh"
 #include <gazebo/physics/World.hh>
 #include <gazebo/sensors/Sensor.hh>
 #include <gazebo/sensors/SensorManager.hh>
 
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <ignition/math/Rand.hh>
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -35,6 +45,12 @@ using namespace gazebo;
 
 GZ_REGISTER_MODEL_PLUGIN(ROSLogicalCameraPlugin);
 
+/// \brief Maximum number of entries of the detected models cache.
+static const size_t kMaxDetectedModels = 1024;
+
+/// \brief Number of gaussian samples drawn at once for a noise stream.
+static const size_t kNoiseBatchSize = 256;
+
 /////////////////////////////////////////////////
 ROSLogicalCameraPlugin::ROSLogicalCameraPlugin()
 {
@@ -43,6 +59,14 @@ ROSLogicalCameraPlugin::ROSLogicalCameraPlugin()
 /////////////////////////////////////////////////
 ROSLogicalCameraPlugin::~ROSLogicalCameraPlugin()
 {
+  if (this->aggregatorId)
+  {
+    LogicalCameraAggregator::Instance().Unregister(this->aggregatorId);
+  }
+  if (this->perceptionId)
+  {
+    LogicalPerceptionEngine::Instance().Unregister(this->perceptionId);
+  }
   this->rosnode->shutdown();
 }
 
@@ -88,7 +112,7 @@ void ROSLogicalCameraPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sd
       std::string type = knownModelTypeElem->Get<std::string>();
 
       ROS_DEBUG_STREAM("New known model type: " << type);
-      this->knownModelTypes.push_back(type);
+      this->knownModelTypes.insert(type);
       knownModelTypeElem = knownModelTypeElem->GetNextElement("type");
     }
   }
@@ -107,7 +131,7 @@ void ROSLogicalCameraPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sd
         std::string knownModelName = knownModelNameElem->Get<std::string>();
 
         ROS_DEBUG_STREAM("New known model name: " << knownModelName);
-        this->knownModelNames.push_back(knownModelName);
+        this->knownModelNames.insert(knownModelName);
         knownModelNameElem = knownModelNameElem->GetNextElement("name");
       }
     }
@@ -131,6 +155,9 @@ void ROSLogicalCameraPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sd
     this->modelFramePrefix = _sdf->GetElement("model_frame_prefix")->Get<std::string>();
   }
   gzdbg << "Using model frame prefix of: " << this->modelFramePrefix << std::endl;
+  this->cameraFrameId = this->name + "_frame";
+  this->kitTrayFrameIds[0] = this->modelFramePrefix + "kit_tray_1_frame";
+  this->kitTrayFrameIds[1] = this->modelFramePrefix + "kit_tray_2_frame";
 
   this->model = _parent;
   this->node = transport::NodePtr(new transport::Node());
@@ -148,17 +175,27 @@ void ROSLogicalCameraPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sd
   this->kitTrayToAgv = ignition::math::Pose3d(kitTrayPosition, kitTrayOrientation);
 
   // Handle noise model settings.
+  // Seed the noise with the seed of the simulation unless told otherwise.
+  // The camera name is mixed in so that the cameras draw independent noise.
+  if (_sdf->HasElement("noise_seed"))
+  {
+    this->noiseGenerator.seed(_sdf->Get<unsigned int>("noise_seed"));
+  }
+  else
+  {
+    std::seed_seq noiseSeed{
+      static_cast<uint32_t>(ignition::math::Rand::Seed()),
+      static_cast<uint32_t>(std::hash<std::string>()(this->name))};
+    this->noiseGenerator.seed(noiseSeed);
+  }
   if (_sdf->HasElement("position_noise"))
   {
-    this->noiseModels["POSITION_NOISE"] =
-      sensors::NoiseFactory::NewNoiseModel(_sdf->GetElement("position_noise")->GetElement("noise"),
-      "logical_camera");
+    this->LoadNoise(_sdf->GetElement("position_noise")->GetElement("noise"), this->positionNoise);
   }
   if (_sdf->HasElement("orientation_noise"))
   {
-    this->noiseModels["ORIENTATION_NOISE"] =
-      sensors::NoiseFactory::NewNoiseModel(_sdf->GetElement("orientation_noise")->GetElement("noise"),
-      "logical_camera");
+    this->LoadNoise(_sdf->GetElement("orientation_noise")->GetElement("noise"),
+      this->orientationNoise);
   }
 
   std::string imageTopic_ros = this->name;
@@ -166,11 +203,61 @@ void ROSLogicalCameraPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sd
     imageTopic_ros = _sdf->Get<std::string>("image_topic_ros");
   }
 
-  this->imageSub = this->node->Subscribe(this->sensor->Topic(),
-          &ROSLogicalCameraPlugin::OnImage, this);
-  gzdbg << "Subscribing to gazebo topic: " << this->sensor->Topic() << "\n";
+  auto markNestedModelsStale = [this](std::string)
+  {
+    this->nestedModelsStale = true;
+  };
+  this->addEntityConnection = event::Events::ConnectAddEntity(markNestedModelsStale);
+  this->deleteEntityConnection = event::Events::ConnectDeleteEntity(markNestedModelsStale);
+
+  this->publishTF = true;
+  if (_sdf->HasElement("publish_tf"))
+  {
+    this->publishTF = _sdf->Get<bool>("publish_tf");
+  }
+
+  this->lazy = false;
+  if (_sdf->HasElement("lazy"))
+  {
+    this->lazy = _sdf->Get<bool>("lazy");
+  }
 
-  this->imagePub = this->rosnode->advertise<nist_gear::LogicalCameraImage>(imageTopic_ros, 1, false);
+  // The sensor sleeps, and its images aren't subscribed to, until
+  // UpdateActivity() wakes it up
+  this->sensor->SetActive(false);
+
+  // With the logical perception engine, the sensor is never woken up; the
+  // engine produces the images instead
+  auto logicalCamera = std::dynamic_pointer_cast<sensors::LogicalCameraSensor>(this->sensor);
+  if (logicalCamera && LogicalPerceptionEngine::Instance().Enabled())
+  {
+    LogicalCameraParams params;
+    params.link = this->cameraLink;
+    // Top level model, as the sensor excludes it
+    params.parentModel = this->cameraLink->GetModel()->GetScopedName();
+    params.parentModel = params.parentModel.substr(0, params.parentModel.find("::"));
+    params.pose = this->sensor->Pose();
+    params.nearClip = logicalCamera->Near();
+    params.farClip = logicalCamera->Far();
+    params.horizontalFov = logicalCamera->HorizontalFOV().Radian();
+    params.aspectRatio = logicalCamera->AspectRatio();
+    if (this->sensor->UpdateRate() > 0)
+    {
+      params.period = common::Time(1.0 / this->sensor->UpdateRate());
+    }
+    this->perceptionId = LogicalPerceptionEngine::Instance().Register(params,
+      std::bind(&ROSLogicalCameraPlugin::ProcessImage, this,
+        std::placeholders::_1, std::placeholders::_2));
+    gzdbg << "Using the logical perception engine for: " << this->sensor->Name() << "\n";
+  }
+
+  ros::AdvertiseOptions imageOptions =
+    ros::AdvertiseOptions::create<nist_gear::LogicalCameraImage>(
+    imageTopic_ros, 1,
+    boost::bind(&ROSLogicalCameraPlugin::OnConsumerConnect, this),
+    boost::bind(&ROSLogicalCameraPlugin::OnConsumerDisconnect, this),
+    ros::VoidPtr(), NULL);
+  this->imagePub = this->rosnode->advertise(imageOptions);
   gzdbg << "Publishing to ROS topic: " << imagePub.getTopic() << "\n";
 
   if (_sdf->HasElement("activation_topic"))
@@ -180,7 +267,78 @@ void ROSLogicalCameraPlugin::Load(physics::ModelPtr _parent, sdf::ElementPtr _sd
             &ROSLogicalCameraPlugin::OnActivationMsg, this);
   }
 
- transformBroadcaster = boost::shared_ptr<tf::TransformBroadcaster>(new tf::TransformBroadcaster());
+  // The TF frames are a by-product of an active camera: every TF listener
+  // subscribes to /tf, so its subscribers don't keep a lazy camera awake
+  if (this->publishTF)
+  {
+    this->tfPub = this->rosnode->advertise<tf2_msgs::TFMessage>("/tf", 100);
+  }
+
+  // Contribute to the fused detections; the quality control sensors, whose
+  // models are anonymized, don't by default
+  bool aggregate = !this->anonymizeModels;
+  if (_sdf->HasElement("aggregate"))
+  {
+    aggregate = _sdf->Get<bool>("aggregate");
+  }
+  if (aggregate)
+  {
+    // The consumers of the fused detections keep the camera awake
+    this->aggregatorId = LogicalCameraAggregator::Instance().Register(this->name,
+      [this](bool _wanted)
+      {
+        if (_wanted)
+        {
+          this->OnConsumerConnect();
+        }
+        else
+        {
+          this->OnConsumerDisconnect();
+        }
+      });
+  }
+
+  std::lock_guard<std::mutex> lock(this->activityMutex);
+  this->UpdateActivity();
+}
+
+/////////////////////////////////////////////////
+void ROSLogicalCameraPlugin::OnConsumerConnect()
+{
+  std::lock_guard<std::mutex> lock(this->activityMutex);
+  this->consumerCount++;
+  this->UpdateActivity();
+}
+
+/////////////////////////////////////////////////
+void ROSLogicalCameraPlugin::OnConsumerDisconnect()
+{
+  std::lock_guard<std::mutex> lock(this->activityMutex);
+  this->consumerCount--;
+  this->UpdateActivity();
+}
+
+/////////////////////////////////////////////////
+void ROSLogicalCameraPlugin::UpdateActivity()
+{
+  bool active = (!this->lazy || this->consumerCount > 0) && this->publishing;
+  if (this->perceptionId)
+  {
+    LogicalPerceptionEngine::Instance().SetActive(this->perceptionId, active);
+  }
+  else if (active && !this->imageSub)
+  {
+    this->imageSub = this->node->Subscribe(this->sensor->Topic(),
+            &ROSLogicalCameraPlugin::OnImage, this);
+    this->sensor->SetActive(true);
+    gzdbg << "Subscribing to gazebo topic: " << this->sensor->Topic() << "\n";
+  }
+  else if (!active && this->imageSub)
+  {
+    this->imageSub.reset();
+    this->sensor->SetActive(false);
+    gzdbg << "Unsubscribing from gazebo topic: " << this->sensor->Topic() << "\n";
+  }
 }
 
 void ROSLogicalCameraPlugin::FindLogicalCamera()
@@ -209,113 +367,185 @@ void ROSLogicalCameraPlugin::FindLogicalCamera()
 
 /////////////////////////////////////////////////
 void ROSLogicalCameraPlugin::OnImage(ConstLogicalCameraImagePtr &_msg)
+{
+  this->ProcessImage(_msg, this->sensor->LastMeasurementTime());
+}
+
+/////////////////////////////////////////////////
+void ROSLogicalCameraPlugin::ProcessImage(ConstLogicalCameraImagePtr &_msg,
+  const common::Time &imageTime)
 {
   if (!this->publishing)
   {
     return;
   }
-  nist_gear::LogicalCameraImage imageMsg;
+
+  // The message buffers are reused from one image to the next
+  this->imageModelCount = 0;
+  this->tfCount = 0;
+  this->detectionCount = 0;
+  bool reportDetections = this->aggregatorId && LogicalCameraAggregator::Instance().Wanted();
+
+  // Models are created and deleted during the competition; bound the cache.
+  // Entries must stay valid while the image is processed.
+  if (this->detectedModels.size() >= kMaxDetectedModels)
+  {
+    this->detectedModels.clear();
+  }
+
+  // The nested models of the detected models are looked up again after any
+  // model insertion or deletion
+  if (this->nestedModelsStale.exchange(false))
+  {
+    for (auto & entry : this->detectedModels)
+    {
+      entry.second.nestedResolved = false;
+      entry.second.nestedModels.clear();
+    }
+  }
+
   ignition::math::Vector3d cameraPosition = msgs::ConvertIgn(_msg->pose().position());
   ignition::math::Quaterniond cameraOrientation =
     msgs::ConvertIgn(_msg->pose().orientation());
   auto cameraPose = ignition::math::Pose3d(cameraPosition, cameraOrientation);
-  this->PublishTF(cameraPose, "world", this->name + "_frame");
+  this->AddTF(cameraPose, "world", this->cameraFrameId);
 
-  imageMsg.pose.position.x = cameraPosition.X();
-  imageMsg.pose.position.y = cameraPosition.Y();
-  imageMsg.pose.position.z = cameraPosition.Z();
-  imageMsg.pose.orientation.x = cameraOrientation.X();
-  imageMsg.pose.orientation.y = cameraOrientation.Y();
-  imageMsg.pose.orientation.z = cameraOrientation.Z();
-  imageMsg.pose.orientation.w = cameraOrientation.W();
+  this->imageMsg.pose.position.x = cameraPosition.X();
+  this->imageMsg.pose.position.y = cameraPosition.Y();
+  this->imageMsg.pose.position.z = cameraPosition.Z();
+  this->imageMsg.pose.orientation.x = cameraOrientation.X();
+  this->imageMsg.pose.orientation.y = cameraOrientation.Y();
+  this->imageMsg.pose.orientation.z = cameraOrientation.Z();
+  this->imageMsg.pose.orientation.w = cameraOrientation.W();
 
-  std::ostringstream logStream;
   ignition::math::Pose3d modelPose;
   for (int i = 0; i < _msg->model_size(); ++i)
   {
-    std::string modelName = _msg->model(i).name();
-    std::string modelType = ariac::DetermineModelType(modelName);
+    const std::string &modelName = _msg->model(i).name();
+    DetectedModel &detected = this->Detected(modelName);
 
-    if (!this->ModelToPublish(modelName, modelType))
-    {
-      logStream << "Not publishing model: " << modelName << " of type: " << modelType << std::endl;
-    }
-    else
+    if (detected.publish)
     {
-      logStream << "Publishing model: " << modelName << " of type: " << modelType << std::endl;
       ignition::math::Vector3d modelPosition =
         msgs::ConvertIgn(_msg->model(i).pose().position());
       ignition::math::Quaterniond modelOrientation =
         msgs::ConvertIgn(_msg->model(i).pose().orientation());
       modelPose = ignition::math::Pose3d(modelPosition, modelOrientation);
 
-      std::string modelNameToUse;
-      std::string modelTypeToUse;
-      if (this->anonymizeModels)
-      {
-        modelNameToUse = "model_" + ariac::DetermineModelId(modelName);
-        modelTypeToUse = "model";
-      }
-      else
-      {
-        modelNameToUse = ariac::TrimNamespace(modelName);
-        modelTypeToUse = modelType;
-      }
-      std::string modelFrameId = this->modelFramePrefix + modelNameToUse + "_frame";
-
-      bool isAgv = modelType == "agv1" || modelType == "agv2";
-      if (isAgv)
+      if (detected.type == "agv1" || detected.type == "agv2")
       {
         // If AGVs are detected, also publish the pose to the respective kit tray.
         // Add noise to the kit tray pose, not the AGV base (it is too much noise by the time the tray pose is extrapolated)
         auto noisyKitTrayPose = ignition::math::Pose3d(this->kitTrayToAgv);
         this->AddNoise(noisyKitTrayPose);
-        if (modelType == "agv1")
-        {
-          this->PublishTF(noisyKitTrayPose, modelFrameId, this->modelFramePrefix + "kit_tray_1_frame");
-        }
-        else if (modelType == "agv2")
-        {
-          this->PublishTF(noisyKitTrayPose, modelFrameId, this->modelFramePrefix + "kit_tray_2_frame");
-        }
+        const std::string &kitTrayFrameId =
+          detected.type == "agv1" ? this->kitTrayFrameIds[0] : this->kitTrayFrameIds[1];
+        this->AddTF(noisyKitTrayPose, detected.frameId, kitTrayFrameId);
       }
       else
       {
         this->AddNoise(modelPose);
       }
-      this->AddModelToMsg(modelTypeToUse, modelPose, imageMsg);
-      this->PublishTF(modelPose, this->name + "_frame", modelFrameId);
-
+      this->AddModelToMsg(detected.typeToUse, modelPose);
+      if (reportDetections)
+      {
+        this->AddDetection(detected.nameToUse, detected.typeToUse, modelPose + cameraPose);
+      }
+      this->AddTF(modelPose, this->cameraFrameId, detected.frameId);
     }
 
     // Check any children models
-    auto modelPtr = this->world->ModelByName(modelName);
-    auto nestedModels = modelPtr->NestedModels();
-    for (auto nestedModel : nestedModels)
+    if (!detected.nestedResolved)
+    {
+      auto modelPtr = EntityCache::Instance().ModelByName(this->world, modelName);
+      if (!modelPtr)
+      {
+        // The model was deleted after the image was generated
+        continue;
+      }
+      for (const auto & nestedModel : modelPtr->NestedModels())
+      {
+        detected.nestedModels.push_back({nestedModel, nestedModel->GetName()});
+      }
+      detected.nestedResolved = true;
+    }
+    for (const auto & nestedEntry : detected.nestedModels)
     {
-      modelName = nestedModel->GetName();
-      modelType = ariac::DetermineModelType(modelName);
-      if (!this->ModelToPublish(modelName, modelType))
+      physics::ModelPtr nestedModel = nestedEntry.model.lock();
+      if (!nestedModel)
+      {
+        continue;
+      }
+      const DetectedModel &nested = this->Detected(nestedEntry.name);
+      if (!nested.publish)
       {
-        logStream << "Not publishing model: " << modelName << " of type: " << modelType << std::endl;
         continue;
       }
-      logStream << "Publishing model: " << modelName << " of type: " << modelType  << std::endl;
       // Convert the world pose of the model into the camera frame
       modelPose = nestedModel->WorldPose() - cameraPose;
       this->AddNoise(modelPose);
-      this->AddModelToMsg(modelType, modelPose, imageMsg);
+      this->AddModelToMsg(nested.type, modelPose);
+      if (reportDetections)
+      {
+        this->AddDetection(nested.nameToUse, nested.type, modelPose + cameraPose);
+      }
       // Do not publish TF information for nested models (kit_tray) because it's not accurate.
       // See https://bitbucket.org/osrf/ariac/issues/54.
-      // this->PublishTF(modelPose, this->name + "_frame", this->modelFramePrefix + ariac::TrimNamespace(modelName) + "_frame");
+      // this->AddTF(modelPose, this->cameraFrameId, nested.frameId);
     }
   }
 
-  if (!logStream.str().empty())
+  // The models are only described when the debug output is printed
+  ROS_DEBUG_STREAM_THROTTLE(1.0, this->DescribeModels(_msg));
+
+  // Drop the entries left over from larger images
+  this->imageMsg.models.resize(this->imageModelCount);
+  this->imagePub.publish(this->imageMsg);
+
+  if (reportDetections)
   {
-    ROS_DEBUG_THROTTLE(1, "%s", logStream.str().c_str());
+    this->detections.resize(this->detectionCount);
+    LogicalCameraAggregator::Instance().Report(this->aggregatorId, imageTime, this->detections);
+  }
+
+  if (this->publishTF)
+  {
+    this->tfMsg.transforms.resize(this->tfCount);
+    for (auto & transform : this->tfMsg.transforms)
+    {
+      transform.header.stamp = ros::Time(imageTime.sec, imageTime.nsec);
+    }
+    this->tfPub.publish(this->tfMsg);
   }
-  this->imagePub.publish(imageMsg);
+}
+
+/////////////////////////////////////////////////
+ROSLogicalCameraPlugin::DetectedModel & ROSLogicalCameraPlugin::Detected(
+  const std::string & modelName)
+{
+  auto it = this->detectedModels.find(modelName);
+  if (it != this->detectedModels.end())
+  {
+    return it->second;
+  }
+
+  DetectedModel &detected = this->detectedModels[modelName];
+  detected.type = ariac::DetermineModelType(modelName);
+  detected.publish = this->ModelToPublish(modelName, detected.type);
+
+  std::string &modelNameToUse = detected.nameToUse;
+  if (this->anonymizeModels)
+  {
+    modelNameToUse = "model_" + ariac::DetermineModelId(modelName);
+    detected.typeToUse = "model";
+  }
+  else
+  {
+    modelNameToUse = ariac::TrimNamespace(modelName);
+    detected.typeToUse = detected.type;
+  }
+  detected.frameId = this->modelFramePrefix + modelNameToUse + "_frame";
+  return detected;
 }
 
 bool ROSLogicalCameraPlugin::ModelToPublish(
@@ -326,45 +556,80 @@ bool ROSLogicalCameraPlugin::ModelToPublish(
   // Check if there are restrictions on which models to publish
   if (this->onlyPublishKnownModels)
   {
-    // Only publish the model if its type is known
-    auto it = std::find(this->knownModelTypes.begin(), this->knownModelTypes.end(), modelType);
-    bool knownModel = it != this->knownModelTypes.end();
-    it = std::find(this->knownModelNames.begin(), this->knownModelNames.end(), ariac::TrimNamespace(modelName));
-    knownModel |= it != this->knownModelNames.end();
-    publishModel = knownModel;
+    // Only publish the model if its type or its name is known
+    publishModel = this->knownModelTypes.count(modelType) > 0 ||
+      this->knownModelNames.count(ariac::TrimNamespace(modelName)) > 0;
   }
   return publishModel;
 }
 
 void ROSLogicalCameraPlugin::AddNoise(ignition::math::Pose3d & pose)
 {
-  if (this->noiseModels.find("POSITION_NOISE") != this->noiseModels.end())
+  if (this->positionNoise.noise)
   {
     // Apply additive noise to the model position
-    pose.Pos().X() =
-      this->noiseModels["POSITION_NOISE"]->Apply(pose.Pos().X());
-    pose.Pos().Y() =
-      this->noiseModels["POSITION_NOISE"]->Apply(pose.Pos().Y());
-    pose.Pos().Z() =
-      this->noiseModels["POSITION_NOISE"]->Apply(pose.Pos().Z());
+    pose.Pos().X() = this->ApplyNoise(this->positionNoise, pose.Pos().X());
+    pose.Pos().Y() = this->ApplyNoise(this->positionNoise, pose.Pos().Y());
+    pose.Pos().Z() = this->ApplyNoise(this->positionNoise, pose.Pos().Z());
   }
 
-  if (this->noiseModels.find("ORIENTATION_NOISE") != this->noiseModels.end())
+  if (this->orientationNoise.noise)
   {
     // Create a perturbation quaternion and apply it to the model orientation
-    double r = this->noiseModels["ORIENTATION_NOISE"]->Apply(0.0);
-    double p = this->noiseModels["ORIENTATION_NOISE"]->Apply(0.0);
-    double y = this->noiseModels["ORIENTATION_NOISE"]->Apply(0.0);
+    double r = this->ApplyNoise(this->orientationNoise, 0.0);
+    double p = this->ApplyNoise(this->orientationNoise, 0.0);
+    double y = this->ApplyNoise(this->orientationNoise, 0.0);
     auto pert = ignition::math::Quaterniond(r, p, y);
     pose.Rot() *= pert;
   }
 }
 
+void ROSLogicalCameraPlugin::LoadNoise(sdf::ElementPtr _noiseElem, NoiseStream & stream)
+{
+  stream.noise = sensors::NoiseFactory::NewNoiseModel(_noiseElem, "logical_camera");
+
+  // Plain gaussian noise is drawn in batches from our own generator. Other
+  // noise models (and quantized gaussian noise) go through Apply().
+  auto gaussian = std::dynamic_pointer_cast<sensors::GaussianNoiseModel>(stream.noise);
+  bool quantized = _noiseElem->HasElement("precision") &&
+    _noiseElem->Get<double>("precision") > 0.0;
+  if (!gaussian || quantized)
+  {
+    return;
+  }
+  stream.batched = true;
+  stream.bias = gaussian->GetBias();
+  stream.distribution = std::normal_distribution<double>(gaussian->GetMean(), gaussian->GetStdDev());
+  stream.samples.resize(kNoiseBatchSize);
+  stream.next = stream.samples.size();
+}
+
+double ROSLogicalCameraPlugin::ApplyNoise(NoiseStream & stream, double value)
+{
+  if (!stream.batched)
+  {
+    return stream.noise->Apply(value);
+  }
+
+  if (stream.next == stream.samples.size())
+  {
+    for (auto & sample : stream.samples)
+    {
+      sample = stream.distribution(this->noiseGenerator);
+    }
+    stream.next = 0;
+  }
+  return value + stream.bias + stream.samples[stream.next++];
+}
+
 void ROSLogicalCameraPlugin::AddModelToMsg(
-  const std::string & modelType, const ignition::math::Pose3d & modelPose,
-  nist_gear::LogicalCameraImage & imageMsg)
+  const std::string & modelType, const ignition::math::Pose3d & modelPose)
 {
-  nist_gear::Model modelMsg;
+  if (this->imageModelCount == this->imageMsg.models.size())
+  {
+    this->imageMsg.models.emplace_back();
+  }
+  nist_gear::Model & modelMsg = this->imageMsg.models[this->imageModelCount++];
   modelMsg.pose.position.x = modelPose.Pos().X();
   modelMsg.pose.position.y = modelPose.Pos().Y();
   modelMsg.pose.position.z = modelPose.Pos().Z();
@@ -374,25 +639,65 @@ void ROSLogicalCameraPlugin::AddModelToMsg(
   modelMsg.pose.orientation.z = modelPose.Rot().Z();
   modelMsg.pose.orientation.w = modelPose.Rot().W();
   modelMsg.type = modelType;
-  imageMsg.models.push_back(modelMsg);
 }
 
-void ROSLogicalCameraPlugin::PublishTF(
+void ROSLogicalCameraPlugin::AddTF(
   const ignition::math::Pose3d & pose, const std::string & parentFrame, const std::string & frame)
 {
-  ros::Time currentTime = ros::Time::now();
-
-  tf::Quaternion qt(pose.Rot().X(), pose.Rot().Y(), pose.Rot().Z(), pose.Rot().W());
-  tf::Vector3 vt(pose.Pos().X(), pose.Pos().Y(), pose.Pos().Z());
+  if (this->tfCount == this->tfMsg.transforms.size())
+  {
+    this->tfMsg.transforms.emplace_back();
+  }
+  geometry_msgs::TransformStamped & transform = this->tfMsg.transforms[this->tfCount++];
+  transform.header.frame_id = parentFrame;
+  transform.child_frame_id = frame;
+  transform.transform.translation.x = pose.Pos().X();
+  transform.transform.translation.y = pose.Pos().Y();
+  transform.transform.translation.z = pose.Pos().Z();
+  transform.transform.rotation.x = pose.Rot().X();
+  transform.transform.rotation.y = pose.Rot().Y();
+  transform.transform.rotation.z = pose.Rot().Z();
+  transform.transform.rotation.w = pose.Rot().W();
+}
 
-  tf::Transform transform (qt, vt);
-  transformBroadcaster->sendTransform(tf::StampedTransform(transform, currentTime, parentFrame, frame));
+/////////////////////////////////////////////////
+void ROSLogicalCameraPlugin::AddDetection(const std::string & modelName,
+  const std::string & modelType, const ignition::math::Pose3d & worldPose)
+{
+  if (this->detectionCount == this->detections.size())
+  {
+    this->detections.emplace_back();
+  }
+  LogicalCameraDetection & detection = this->detections[this->detectionCount++];
+  detection.name = modelName;
+  detection.type = modelType;
+  detection.pose = worldPose;
+}
 
+/////////////////////////////////////////////////
+std::string ROSLogicalCameraPlugin::DescribeModels(ConstLogicalCameraImagePtr &_msg)
+{
+  std::ostringstream description;
+  for (int i = 0; i < _msg->model_size(); ++i)
+  {
+    const std::string &modelName = _msg->model(i).name();
+    const DetectedModel &detected = this->Detected(modelName);
+    description << (detected.publish ? "Publishing model: " : "Not publishing model: ")
+                << modelName << " of type: " << detected.type << std::endl;
+    for (const auto & nestedEntry : detected.nestedModels)
+    {
+      const DetectedModel &nested = this->Detected(nestedEntry.name);
+      description << (nested.publish ? "Publishing model: " : "Not publishing model: ")
+                  << nestedEntry.name << " of type: " << nested.type << std::endl;
+    }
+  }
+  return description.str();
 }
 
 /////////////////////////////////////////////////
 void ROSLogicalCameraPlugin::OnActivationMsg(ConstGzStringPtr &_msg)
 {
+  std::lock_guard<std::mutex> lock(this->activityMutex);
   if (_msg->data() == "activate")
   {
     this->publishing = true;
@@ -400,9 +705,16 @@ void ROSLogicalCameraPlugin::OnActivationMsg(ConstGzStringPtr &_msg)
   else if (_msg->data() == "deactivate")
   {
     this->publishing = false;
+    if (this->aggregatorId)
+    {
+      LogicalCameraAggregator::Instance().Clear(this->aggregatorId);
+    }
   }
   else
   {
     gzerr << "Unknown activation command [" << _msg->data() << "]" << std::endl;
   }
+
+  // The sensor also sleeps during a blackout
+  this->UpdateActivity();
 }
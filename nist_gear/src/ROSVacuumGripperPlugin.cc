@@ -16,12 +16,14 @@
 */
 
 #include <memory>
+#include <sstream>
 #include <string>
 #include <ros/ros.h>
 #include <sdf/sdf.hh>
 #include "nist_gear/ROSVacuumGripperPlugin.hh"
 #include "nist_gear/VacuumGripperControl.h"
 #include "nist_gear/VacuumGripperState.h"
+#include "nist_gear/VacuumGripperStats.h"
 
 namespace gazebo
 {
@@ -37,6 +39,15 @@ namespace gazebo
 
     /// \brief Receives service calls to control the gripper.
     public: ros::ServiceServer controlService;
+
+    /// \brief Publishes the grasp statistics of the gripper.
+    public: ros::Publisher statsPub;
+
+    /// \brief Receives the competition state.
+    public: ros::Subscriber competitionStateSub;
+
+    /// \brief Whether the grasp statistics were dumped.
+    public: bool statsDumped = false;
   };
 }
 
@@ -54,6 +65,8 @@ ROSVacuumGripperPlugin::ROSVacuumGripperPlugin()
 /////////////////////////////////////////////////
 ROSVacuumGripperPlugin::~ROSVacuumGripperPlugin()
 {
+  // In case the trial didn't reach the end
+  this->DumpStats();
   this->dataPtr->rosnode->shutdown();
 }
 
@@ -86,6 +99,14 @@ void ROSVacuumGripperPlugin::Load(physics::ModelPtr _parent,
   if (_sdf->HasElement("state_topic"))
     stateTopic = _sdf->Get<std::string>("state_topic");
 
+  std::string statsTopic = "gripper/stats";
+  if (_sdf->HasElement("stats_topic"))
+    statsTopic = _sdf->Get<std::string>("stats_topic");
+
+  std::string competitionStateTopic = "/ariac/competition_state";
+  if (_sdf->HasElement("competition_state_topic"))
+    competitionStateTopic = _sdf->Get<std::string>("competition_state_topic");
+
   VacuumGripperPlugin::Load(_parent, _sdf);
 
   this->dataPtr->rosnode.reset(new ros::NodeHandle(robotNamespace));
@@ -98,6 +119,13 @@ void ROSVacuumGripperPlugin::Load(physics::ModelPtr _parent,
   // Message used for publishing the state of the gripper.
   this->dataPtr->statePub = this->dataPtr->rosnode->advertise<
     nist_gear::VacuumGripperState>(stateTopic, 1000);
+
+  // Statistics of the grasp pipeline, latched so late subscribers get the last ones.
+  this->dataPtr->statsPub = this->dataPtr->rosnode->advertise<
+    nist_gear::VacuumGripperStats>(statsTopic, 10, true);
+
+  this->dataPtr->competitionStateSub = this->dataPtr->rosnode->subscribe(
+    competitionStateTopic, 10, &ROSVacuumGripperPlugin::OnCompetitionState, this);
 }
 
 /////////////////////////////////////////////////
@@ -120,11 +148,96 @@ bool ROSVacuumGripperPlugin::OnGripperControl(
   return _res.success;
 }
 
+/////////////////////////////////////////////////
+void ROSVacuumGripperPlugin::OnCompetitionState(const std_msgs::String::ConstPtr &_msg)
+{
+  if (_msg->data == "done")
+  {
+    this->PublishStats();
+    this->DumpStats();
+  }
+}
+
+/////////////////////////////////////////////////
+void ROSVacuumGripperPlugin::DumpStats()
+{
+  if (this->dataPtr->statsDumped)
+    return;
+  this->dataPtr->statsDumped = true;
+
+  std::ostringstream out;
+  this->PrintStats(out);
+  gzmsg << out.str();
+}
+
+/////////////////////////////////////////////////
+void ROSVacuumGripperPlugin::PublishStats() const
+{
+  auto stats = this->Stats();
+  auto seconds = [](const common::Time &_from, const common::Time &_to)
+  {
+    return (_from == common::Time::Zero || _to == common::Time::Zero) ?
+      -1.0 : (_to - _from).Double();
+  };
+
+  nist_gear::VacuumGripperStats msg;
+  msg.gripper_name = this->Name();
+  msg.grasp_count = stats.grasps.size();
+  msg.attached = this->Attached();
+  msg.last_enable_to_contact = -1;
+  msg.last_contact_to_attach = -1;
+  msg.last_attach_to_detach = -1;
+  msg.mean_enable_to_contact = -1;
+  msg.mean_contact_to_attach = -1;
+  msg.mean_attach_to_detach = -1;
+
+  // Means only cover the grasps in which both ends of the interval were reached
+  double sums[3] = {0, 0, 0};
+  unsigned int counts[3] = {0, 0, 0};
+  for (const auto &grasp : stats.grasps)
+  {
+    double durations[3] = {
+      seconds(grasp.enableTime, grasp.firstContactTime),
+      seconds(grasp.firstContactTime, grasp.attachTime),
+      seconds(grasp.attachTime, grasp.detachTime)};
+    for (int i = 0; i < 3; ++i)
+    {
+      if (durations[i] < 0)
+        continue;
+      sums[i] += durations[i];
+      counts[i]++;
+    }
+  }
+  if (counts[0])
+    msg.mean_enable_to_contact = sums[0] / counts[0];
+  if (counts[1])
+    msg.mean_contact_to_attach = sums[1] / counts[1];
+  if (counts[2])
+    msg.mean_attach_to_detach = sums[2] / counts[2];
+
+  if (!stats.grasps.empty())
+  {
+    const auto &last = stats.grasps.back();
+    msg.last_enable_to_contact = seconds(last.enableTime, last.firstContactTime);
+    msg.last_contact_to_attach = seconds(last.firstContactTime, last.attachTime);
+    msg.last_attach_to_detach = seconds(last.attachTime, last.detachTime);
+  }
+
+  msg.evaluated_updates = stats.evaluatedUpdates;
+  msg.gated_updates = stats.gatedUpdates;
+  msg.contact_histogram = stats.contactHistogram;
+  this->dataPtr->statsPub.publish(msg);
+}
+
 /////////////////////////////////////////////////
 void ROSVacuumGripperPlugin::Publish() const
 {
   nist_gear::VacuumGripperState msg;
   msg.attached = this->Attached();
   msg.enabled = this->Enabled();
+  common::Time attachTime = this->LastAttachTime();
+  common::Time detachTime = this->LastDetachTime();
+  msg.attach_time = ros::Time(attachTime.sec, attachTime.nsec);
+  msg.detach_time = ros::Time(detachTime.sec, detachTime.nsec);
   this->dataPtr->statePub.publish(msg);
 }
@@ -19,6 +19,8 @@
 #include <string>
 
 #include "SideContactPlugin.hh"
+#include "nist_gear/EntityCache.hh"
+#include "nist_gear/ModelPool.hh"
 #include <ignition/math/Vector3.hh>
 
 using namespace gazebo;
@@ -32,6 +34,8 @@ SideContactPlugin::SideContactPlugin() : ModelPlugin()
 /////////////////////////////////////////////////
 SideContactPlugin::~SideContactPlugin()
 {
+  if (this->contactListenerId)
+    ContactDispatcher::Instance().Unregister(this->contactListenerId);
   this->updateConnection.reset();
   this->parentSensor.reset();
   this->world.reset();
@@ -110,11 +114,23 @@ void SideContactPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
 
   this->lastUpdateTime = this->world->SimTime();
 
-  // FIXME: how to not hard-code this gazebo prefix?
-  std::string contactTopic = "/gazebo/" + this->scopedContactSensorName;
-  boost::replace_all(contactTopic, "::", "/");
-  this->contactSub =
-    this->node->Subscribe(contactTopic, &SideContactPlugin::OnContactsReceived, this);
+  physics::CollisionPtr collision =
+    EntityCache::Instance().CollisionByName(this->world, this->collisionName);
+  if (ContactDispatcher::Instance().Enabled() && collision)
+  {
+    // Contacts are handed over in-process, so the sensor has nothing to do
+    this->contactListenerId = ContactDispatcher::Instance().Register({collision},
+      std::bind(&SideContactPlugin::OnContactRecords, this, std::placeholders::_1));
+    this->parentSensor->SetActive(false);
+  }
+  else
+  {
+    // FIXME: how to not hard-code this gazebo prefix?
+    std::string contactTopic = "/gazebo/" + this->scopedContactSensorName;
+    boost::replace_all(contactTopic, "::", "/");
+    this->contactSub =
+      this->node->Subscribe(contactTopic, &SideContactPlugin::OnContactsReceived, this);
+  }
 
   // Listen to the update event. This event is broadcast every
   // simulation iteration.
@@ -151,7 +167,22 @@ bool SideContactPlugin::FindContactSensor()
 void SideContactPlugin::OnContactsReceived(ConstContactsPtr& _msg)
 {
   boost::mutex::scoped_lock lock(this->mutex);
-  this->newestContactsMsg = *_msg;
+  this->newestContactsMsg = _msg;
+  this->newMsg = true;
+}
+
+/////////////////////////////////////////////////
+void SideContactPlugin::OnContactRecords(const std::vector<ContactRecord> &_records)
+{
+  std::set<physics::LinkPtr> links;
+  for (const auto &record : _records)
+  {
+    if (record.other)
+      links.insert(record.other->GetLink());
+  }
+
+  boost::mutex::scoped_lock lock(this->mutex);
+  this->dispatchedLinks.swap(links);
   this->newMsg = true;
 }
 
@@ -164,32 +195,50 @@ void SideContactPlugin::OnUpdate(const common::UpdateInfo &/*_info*/)
 /////////////////////////////////////////////////
 void SideContactPlugin::CalculateContactingLinks()
 {
-  boost::mutex::scoped_lock lock(this->mutex);
-
-  if (!this->newMsg)
+  if (this->contactListenerId)
   {
+    // The links were already resolved by OnContactRecords
+    boost::mutex::scoped_lock lock(this->mutex);
+    if (this->newMsg)
+    {
+      this->contactingLinks.swap(this->dispatchedLinks);
+      this->newMsg = false;
+    }
     return;
   }
 
-  this->contactingLinks.clear();
+  ConstContactsPtr msg;
+  {
+    boost::mutex::scoped_lock lock(this->mutex);
+    if (!this->newMsg)
+    {
+      return;
+    }
+    msg = this->newestContactsMsg;
+    this->newMsg = false;
+  }
+
+  std::set<physics::LinkPtr> links;
 
   // Get all the contacts
-  for (int i = 0; i < this->newestContactsMsg.contact_size(); ++i)
+  for (int i = 0; i < msg->contact_size(); ++i)
   {
     // Get the collision that's not the parent link
-    const auto &contact = this->newestContactsMsg.contact(i);
+    const auto &contact = msg->contact(i);
     const std::string *collision = &(contact.collision1());
     if (this->collisionName == *collision) {
       collision = &(contact.collision2());
     }
 
     physics::CollisionPtr collisionPtr =
-      boost::static_pointer_cast<physics::Collision>(this->world->EntityByName(*collision));
+      EntityCache::Instance().CollisionByName(this->world, *collision);
     if (collisionPtr) { // ensure the collision hasn't been deleted
-      this->contactingLinks.insert(collisionPtr->GetLink());
+      links.insert(collisionPtr->GetLink());
     }
   }
-  this->newMsg = false;
+
+  boost::mutex::scoped_lock lock(this->mutex);
+  this->contactingLinks.swap(links);
 }
 
 /////////////////////////////////////////////////
@@ -209,16 +258,11 @@ void SideContactPlugin::ClearContactingModels()
 {
   boost::mutex::scoped_lock lock(this->mutex);
 
-  // Static because multiple plugin instances may exist, and we want them to share the state
-  static int index = 0;
-
+  // The pool is shared by all the plugin instances, so parking slots are reused
   for (auto model : this->contactingModels)
   {
-    gzdbg << "Teleporting model: " << model->GetScopedName() << std::endl;
-    model->SetAutoDisable(true);
-    model->SetGravityMode(true);
-    model->SetStatic(true);
-    model->SetWorldPose(ignition::math::Pose3d(0 + 0.25*index++, 0, -5, 0, 0, 0));
+    if (model)
+      ModelPool::Instance().Release(model);
   }
 }
 
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <gazebo/common/Console.hh>
+#include <gazebo/physics/Collision.hh>
+#include <gazebo/physics/Contact.hh>
+#include <gazebo/physics/ContactManager.hh>
+#include <gazebo/physics/PhysicsEngine.hh>
+#include <gazebo/physics/World.hh>
+
+#include "nist_gear/VacuumGripperManager.hh"
+
+using namespace gazebo;
+
+/////////////////////////////////////////////////
+VacuumGripperManager &VacuumGripperManager::Instance()
+{
+  static VacuumGripperManager instance;
+  return instance;
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperManager::Enable(const physics::WorldPtr &_world)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (this->world)
+  {
+    gzwarn << "VacuumGripperManager already enabled" << std::endl;
+    return;
+  }
+  this->world = _world;
+
+  // The dispatcher already reads the contacts once per step
+  this->useDispatcher = ContactDispatcher::Instance().Enabled();
+  if (this->useDispatcher)
+    return;
+
+  // Contacts are normally only kept when a filter or the contact topic has
+  // subscribers. The manager reads them without going through either.
+  this->world->Physics()->GetContactManager()->SetNeverDropContacts(true);
+
+  this->updateConnection = event::Events::ConnectWorldUpdateEnd(
+    std::bind(&VacuumGripperManager::OnWorldUpdateEnd, this));
+}
+
+/////////////////////////////////////////////////
+bool VacuumGripperManager::Enabled()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->world != nullptr;
+}
+
+/////////////////////////////////////////////////
+unsigned int VacuumGripperManager::Register(
+  const std::vector<physics::CollisionPtr> &_collisions,
+  const ContactsCallback &_onContacts, const UpdateCallback &_onUpdate)
+{
+  std::lock_guard<std::mutex> registrationLock(this->registrationMutex);
+  unsigned int id;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    id = this->nextId++;
+    GripperEntry &entry = this->grippers[id];
+    entry.onContacts = _onContacts;
+    entry.onUpdate = _onUpdate;
+    for (const auto &collision : _collisions)
+    {
+      if (!collision)
+        continue;
+      entry.collisions.push_back(collision);
+      this->byCollision[collision->GetId()] = id;
+    }
+  }
+
+  if (this->useDispatcher)
+    this->RegisterWithDispatcher();
+  return id;
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperManager::Unregister(unsigned int _id)
+{
+  std::lock_guard<std::mutex> registrationLock(this->registrationMutex);
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->grippers.find(_id);
+    if (it == this->grippers.end())
+      return;
+
+    for (const auto &collision : it->second.collisions)
+      this->byCollision.erase(collision->GetId());
+    this->grippers.erase(it);
+  }
+
+  if (this->useDispatcher)
+    this->RegisterWithDispatcher();
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperManager::RegisterWithDispatcher()
+{
+  std::vector<physics::CollisionPtr> collisions;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (const auto &gripper : this->grippers)
+    {
+      collisions.insert(collisions.end(),
+        gripper.second.collisions.begin(), gripper.second.collisions.end());
+    }
+  }
+
+  // Unregister first, so that the grippers are never updated twice in a step
+  auto &dispatcher = ContactDispatcher::Instance();
+  if (this->dispatcherListenerId)
+    dispatcher.Unregister(this->dispatcherListenerId);
+  this->dispatcherListenerId = 0;
+
+  if (!collisions.empty())
+  {
+    this->dispatcherListenerId = dispatcher.Register(collisions,
+      std::bind(&VacuumGripperManager::OnContactRecords, this, std::placeholders::_1));
+  }
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperManager::OnContactRecords(const std::vector<ContactRecord> &_records)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  for (auto &gripper : this->grippers)
+    gripper.second.batch.clear();
+
+  // Records are oriented with the suction cup collision first
+  for (const auto &record : _records)
+  {
+    auto owner = this->byCollision.find(record.collision->GetId());
+    if (owner != this->byCollision.end())
+      this->grippers[owner->second].batch.push_back(record);
+  }
+
+  this->UpdateGrippers();
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperManager::OnWorldUpdateEnd()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (this->grippers.empty())
+    return;
+
+  for (auto &gripper : this->grippers)
+    gripper.second.batch.clear();
+
+  auto mgr = this->world->Physics()->GetContactManager();
+  const auto &contacts = mgr->GetContacts();
+  unsigned int contactCount = std::min<size_t>(mgr->GetContactCount(), contacts.size());
+
+  for (unsigned int i = 0; i < contactCount; ++i)
+  {
+    const physics::Contact *contact = contacts[i];
+    if (!contact || !contact->collision1 || !contact->collision2)
+      continue;
+
+    auto owner1 = this->byCollision.find(contact->collision1->GetId());
+    auto owner2 = this->byCollision.find(contact->collision2->GetId());
+    if (owner1 == this->byCollision.end() && owner2 == this->byCollision.end())
+      continue;
+
+    ContactRecord record;
+    record.collision = boost::static_pointer_cast<physics::Collision>(
+      contact->collision1->shared_from_this());
+    record.other = boost::static_pointer_cast<physics::Collision>(
+      contact->collision2->shared_from_this());
+    record.normal = contact->count > 0 ? contact->normals[0] : ignition::math::Vector3d::Zero;
+    record.count = contact->count;
+    record.time = contact->time;
+
+    if (owner1 != this->byCollision.end())
+      this->grippers[owner1->second].batch.push_back(record);
+
+    if (owner2 != this->byCollision.end())
+    {
+      // Seen from collision2, the frames are reversed
+      std::swap(record.collision, record.other);
+      record.normal = -record.normal;
+      this->grippers[owner2->second].batch.push_back(record);
+    }
+  }
+
+  this->UpdateGrippers();
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperManager::UpdateGrippers()
+{
+  for (auto &gripper : this->grippers)
+  {
+    gripper.second.onContacts(gripper.second.batch);
+    gripper.second.onUpdate();
+  }
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gazebo/common/Assert.hh>
+#include <gazebo/common/Console.hh>
+#include <gazebo/physics/World.hh>
+
+#include "nist_gear/VacuumGripperManager.hh"
+#include "nist_gear/VacuumGripperManagerPlugin.hh"
+
+using namespace gazebo;
+
+GZ_REGISTER_WORLD_PLUGIN(VacuumGripperManagerPlugin)
+
+/////////////////////////////////////////////////
+VacuumGripperManagerPlugin::VacuumGripperManagerPlugin()
+{
+}
+
+/////////////////////////////////////////////////
+VacuumGripperManagerPlugin::~VacuumGripperManagerPlugin()
+{
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperManagerPlugin::Load(physics::WorldPtr _world, sdf::ElementPtr /*_sdf*/)
+{
+  GZ_ASSERT(_world, "VacuumGripperManagerPlugin world pointer is NULL");
+  VacuumGripperManager::Instance().Enable(_world);
+  gzdbg << "VacuumGripperManagerPlugin: managing the vacuum grippers of "
+        << _world->Name() << std::endl;
+}
@@ -20,9 +20,13 @@
   #include <Winsock2.h>
 #endif
 
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <mutex>
 #include <ostream>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 #include <gazebo/common/Events.hh>
@@ -38,9 +42,18 @@
 #include <gazebo/transport/Subscriber.hh>
 #include "nist_gear/VacuumGripperPlugin.hh"
 #include "nist_gear/ARIAC.hh"
+#include "nist_gear/ContactDispatcher.hh"
+#include "nist_gear/VacuumGripperManager.hh"
+#include "nist_gear/EntityCache.hh"
 
 namespace gazebo
 {
+  /// \brief Maximum number of contacts with the suction cup kept per update.
+  static const size_t kMaxGripperContacts = 32;
+
+  /// \brief Number of bins of the contact count histogram.
+  static const size_t kContactHistogramBins = 16;
+
   /// \internal
   /// \brief Private data for the VacuumGripperPlugin class
   struct VacuumGripperPluginPrivate
@@ -94,12 +107,49 @@ namespace gazebo
               };
             };
 
-    /// \brief Collection of objects that have been dropped.
-    public: std::vector<std::string> droppedObjects;
+    /// \brief Types of the objects that have been dropped.
+    public: std::unordered_set<std::string> droppedObjects;
 
     /// \brief Collection of objects to be dropped.
     public: std::vector<DropObject> objectsToDrop;
 
+    /// \brief Indices in objectsToDrop of the drops of each object type.
+    public: std::unordered_map<std::string, std::vector<size_t>> dropsByType;
+
+    /// \brief Transforms of a drop frame, computed once per tick.
+    public: struct DropFrameTransform
+            {
+              /// \brief Simulation time the transforms were computed at.
+              common::Time tick;
+
+              /// \brief Transform of the frame in the world.
+              ignition::math::Matrix4d transform;
+
+              /// \brief Inverse of transform.
+              ignition::math::Matrix4d inverse;
+            };
+
+    /// \brief Transforms of the drop frames, by frame.
+    public: std::unordered_map<physics::Entity *, DropFrameTransform> dropFrames;
+
+    /// \brief Get the transforms of a drop frame for the current tick.
+    /// \param[in] _frame The frame.
+    /// \return The transforms.
+    public: const DropFrameTransform &FrameTransform(const physics::EntityPtr &_frame)
+            {
+              auto now = this->world->SimTime();
+              auto it = this->dropFrames.find(_frame.get());
+              if (it == this->dropFrames.end() || it->second.tick != now)
+              {
+                DropFrameTransform &cached = this->dropFrames[_frame.get()];
+                cached.tick = now;
+                cached.transform = ignition::math::Matrix4d(_frame->WorldPose());
+                cached.inverse = cached.transform.Inverse();
+                return cached;
+              }
+              return it->second;
+            }
+
     /// \brief Model that contains this gripper.
     public: physics::ModelPtr model;
 
@@ -118,8 +168,86 @@ namespace gazebo
     /// \brief The collisions for the links in the gripper.
     public: std::map<std::string, physics::CollisionPtr> collisions;
 
-    /// \brief The current contacts.
-    public: std::vector<msgs::Contact> contacts;
+    /// \brief A contact with the suction cup, in the frame of the gripper.
+    public: struct GripperContact
+            {
+              /// \brief Collision touching the suction cup.
+              physics::CollisionPtr other;
+
+              /// \brief Normal of the first contact point.
+              ignition::math::Vector3d normal;
+
+              /// \brief Number of contact points.
+              int count = 0;
+            };
+
+    /// \brief Contacts accepted during the last update. Only the first
+    /// min(contactCount, kMaxGripperContacts) entries are valid.
+    public: std::array<GripperContact, kMaxGripperContacts> contacts;
+
+    /// \brief Number of contacts accepted during the last update. Can be
+    /// larger than the capacity of the buffer.
+    public: size_t contactCount = 0;
+
+    /// \brief The collisions of the suction cup, by id.
+    public: std::unordered_map<uint32_t, physics::CollisionPtr> suctionCollisions;
+
+    /// \brief Other collisions that touched the suction cup, by id.
+    public: std::unordered_map<uint32_t, boost::weak_ptr<physics::Collision>> collisionCache;
+
+    /// \brief Store an accepted contact.
+    /// \param[in] _other Collision touching the suction cup.
+    /// \param[in] _normal Normal of the first contact point.
+    /// \param[in] _count Number of contact points.
+    public: void AddContact(const physics::CollisionPtr &_other,
+                            const ignition::math::Vector3d &_normal, int _count)
+            {
+              if (this->contactCount < kMaxGripperContacts)
+              {
+                auto &contact = this->contacts[this->contactCount];
+                contact.other = _other;
+                contact.normal = _normal;
+                contact.count = _count;
+              }
+              ++this->contactCount;
+            }
+
+    /// \brief Find a collision of a contact message.
+    /// \param[in] _id Id of the collision, or 0 if unknown.
+    /// \param[in] _name Scoped name of the collision.
+    /// \return The collision, or null if it no longer exists.
+    public: physics::CollisionPtr ResolveCollision(uint32_t _id, const std::string &_name)
+            {
+              if (_id)
+              {
+                auto suction = this->suctionCollisions.find(_id);
+                if (suction != this->suctionCollisions.end())
+                  return suction->second;
+
+                auto cached = this->collisionCache.find(_id);
+                if (cached != this->collisionCache.end())
+                {
+                  physics::CollisionPtr collision = cached->second.lock();
+                  if (collision)
+                    return collision;
+                  this->collisionCache.erase(cached);
+                }
+              }
+
+              physics::CollisionPtr collision =
+                EntityCache::Instance().CollisionByName(this->world, _name);
+              if (collision)
+                this->collisionCache[collision->GetId()] = collision;
+              return collision;
+            }
+
+    /// \brief Id of the ContactDispatcher listener, 0 when contacts are
+    /// received from a contact manager filter
+    public: unsigned int contactListenerId = 0;
+
+    /// \brief Id in the VacuumGripperManager, 0 when the gripper isn't
+    /// managed.
+    public: unsigned int managerId = 0;
 
     /// \brief Mutex used to protect reading/writing the sonar message.
     public: std::mutex mutex;
@@ -133,6 +261,37 @@ namespace gazebo
     /// \brief Previous time when the gripper was updated.
     public: common::Time prevUpdateTime;
 
+    /// \brief Simulation time of the last attach.
+    public: common::Time attachTime;
+
+    /// \brief Simulation time of the last detach.
+    public: common::Time detachTime;
+
+    /// \brief Period after which an unchanged state is published again.
+    /// Zero disables the keepalive.
+    public: common::Time stateKeepalivePeriod = common::Time(0.1);
+
+    /// \brief Last time the state was published.
+    public: common::Time lastStatePublishTime;
+
+    /// \brief Whether the state was published since the last reset.
+    public: bool statePublished = false;
+
+    /// \brief Enabled flag of the last published state.
+    public: bool publishedEnabled = false;
+
+    /// \brief Attached flag of the last published state.
+    public: bool publishedAttached = false;
+
+    /// \brief Grasp in progress.
+    public: VacuumGripperGrasp currentGrasp;
+
+    /// \brief Statistics of the grasp pipeline.
+    public: VacuumGripperStats stats;
+
+    /// \brief Protects the statistics. Locked after mutex when both are needed.
+    public: mutable std::mutex statsMutex;
+
     /// \brief Number of iterations the gripper was contacting the same
     /// object.
     public: int posCount;
@@ -206,7 +365,15 @@ VacuumGripperPlugin::VacuumGripperPlugin()
 /////////////////////////////////////////////////
 VacuumGripperPlugin::~VacuumGripperPlugin()
 {
-  if (this->dataPtr->world && this->dataPtr->world->Running())
+  if (this->dataPtr->managerId)
+  {
+    VacuumGripperManager::Instance().Unregister(this->dataPtr->managerId);
+  }
+  else if (this->dataPtr->contactListenerId)
+  {
+    ContactDispatcher::Instance().Unregister(this->dataPtr->contactListenerId);
+  }
+  else if (this->dataPtr->world && this->dataPtr->world->Running())
   {
     auto mgr = this->dataPtr->world->Physics()->GetContactManager();
     mgr->RemoveFilter(this->Name());
@@ -223,6 +390,14 @@ void VacuumGripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
   this->dataPtr->node->Init(this->dataPtr->world->Name());
   this->dataPtr->name = _sdf->Get<std::string>("name");
 
+  // The state is published on changes, and at a low rate otherwise
+  if (_sdf->HasElement("state_keepalive_rate"))
+  {
+    double keepaliveRate = _sdf->Get<double>("state_keepalive_rate");
+    this->dataPtr->stateKeepalivePeriod =
+      keepaliveRate > 0 ? common::Time(1.0 / keepaliveRate) : common::Time::Zero;
+  }
+
   // Create the joint that will attach the objects to the suction cup
   this->dataPtr->fixedJoint =
       this->dataPtr->world->Physics()->CreateJoint(
@@ -349,6 +524,7 @@ void VacuumGripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
       ignition::math::Pose3d destination = dstElement->Get<ignition::math::Pose3d>();
 
       VacuumGripperPluginPrivate::DropObject dropObject {type, dropRegion, destination, dropFrame};
+      this->dataPtr->dropsByType[type].push_back(this->dataPtr->objectsToDrop.size());
       this->dataPtr->objectsToDrop.push_back(dropObject);
 
       dropRegionElem = dropRegionElem->GetNextElement("drop_region");
@@ -367,9 +543,33 @@ void VacuumGripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
       continue;
 
     this->dataPtr->collisions[collision->GetScopedName()] = collision;
+    this->dataPtr->suctionCollisions[collision->GetId()] = collision;
   }
 
-  if (!this->dataPtr->collisions.empty())
+  this->Reset();
+
+  if (VacuumGripperManager::Instance().Enabled())
+  {
+    // The manager hands the contacts over and updates all the grippers
+    std::vector<physics::CollisionPtr> suctionCollisions;
+    for (const auto &collision : this->dataPtr->collisions)
+      suctionCollisions.push_back(collision.second);
+    this->dataPtr->managerId = VacuumGripperManager::Instance().Register(suctionCollisions,
+      std::bind(&VacuumGripperPlugin::OnContactRecords, this, std::placeholders::_1),
+      std::bind(&VacuumGripperPlugin::OnUpdate, this));
+    return;
+  }
+
+  if (!this->dataPtr->collisions.empty() && ContactDispatcher::Instance().Enabled())
+  {
+    // Receive the contacts in-process
+    std::vector<physics::CollisionPtr> suctionCollisions;
+    for (const auto &collision : this->dataPtr->collisions)
+      suctionCollisions.push_back(collision.second);
+    this->dataPtr->contactListenerId = ContactDispatcher::Instance().Register(suctionCollisions,
+      std::bind(&VacuumGripperPlugin::OnContactRecords, this, std::placeholders::_1));
+  }
+  else if (!this->dataPtr->collisions.empty())
   {
     // Create a filter to receive collision information
     auto mgr = this->dataPtr->world->Physics()->GetContactManager();
@@ -381,8 +581,6 @@ void VacuumGripperPlugin::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
     }
   }
 
-  this->Reset();
-
   this->dataPtr->connection = event::Events::ConnectWorldUpdateEnd(
       boost::bind(&VacuumGripperPlugin::OnUpdate, this));
 }
@@ -395,6 +593,14 @@ void VacuumGripperPlugin::Reset()
   this->dataPtr->posCount = 0;
   this->dataPtr->attached = false;
   this->dataPtr->enabled = false;
+  this->dataPtr->attachTime = common::Time::Zero;
+  this->dataPtr->detachTime = common::Time::Zero;
+  this->dataPtr->statePublished = false;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->statsMutex);
+  this->dataPtr->currentGrasp = VacuumGripperGrasp();
+  this->dataPtr->stats = VacuumGripperStats();
+  this->dataPtr->stats.contactHistogram.assign(kContactHistogramBins, 0);
 }
 
 /////////////////////////////////////////////////
@@ -415,10 +621,85 @@ bool VacuumGripperPlugin::Attached() const
   return this->dataPtr->attached;
 }
 
+/////////////////////////////////////////////////
+common::Time VacuumGripperPlugin::LastAttachTime() const
+{
+  return this->dataPtr->attachTime;
+}
+
+/////////////////////////////////////////////////
+common::Time VacuumGripperPlugin::LastDetachTime() const
+{
+  return this->dataPtr->detachTime;
+}
+
+/////////////////////////////////////////////////
+VacuumGripperStats VacuumGripperPlugin::Stats() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->statsMutex);
+  return this->dataPtr->stats;
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperPlugin::PrintStats(std::ostream &_out) const
+{
+  auto stats = this->Stats();
+  auto seconds = [](const common::Time &_from, const common::Time &_to)
+  {
+    return (_from == common::Time::Zero || _to == common::Time::Zero) ?
+      -1.0 : (_to - _from).Double();
+  };
+
+  _out << "Grasp statistics of gripper [" << this->Name() << "]" << std::endl;
+  _out << "  grasp, enable_to_contact, contact_to_attach, attach_to_detach (s)" << std::endl;
+  for (size_t i = 0; i < stats.grasps.size(); ++i)
+  {
+    const auto &grasp = stats.grasps[i];
+    _out << "  " << i << ", " << seconds(grasp.enableTime, grasp.firstContactTime)
+         << ", " << seconds(grasp.firstContactTime, grasp.attachTime)
+         << ", " << seconds(grasp.attachTime, grasp.detachTime) << std::endl;
+  }
+  _out << "  updates evaluated: " << stats.evaluatedUpdates
+       << ", gated by the update rate: " << stats.gatedUpdates << std::endl;
+  _out << "  contacts per evaluated update:";
+  for (size_t i = 0; i < stats.contactHistogram.size(); ++i)
+  {
+    _out << " " << i << (i + 1 == stats.contactHistogram.size() ? "+" : "")
+         << ":" << stats.contactHistogram[i];
+  }
+  _out << std::endl;
+}
+
+/////////////////////////////////////////////////
+void VacuumGripperPlugin::PublishIfNeeded()
+{
+  auto now = this->dataPtr->world->SimTime();
+  bool changed = !this->dataPtr->statePublished ||
+    this->dataPtr->publishedEnabled != this->dataPtr->enabled ||
+    this->dataPtr->publishedAttached != this->dataPtr->attached;
+  bool keepaliveDue = this->dataPtr->stateKeepalivePeriod > common::Time::Zero &&
+    now - this->dataPtr->lastStatePublishTime >= this->dataPtr->stateKeepalivePeriod;
+  if (!changed && !keepaliveDue)
+    return;
+
+  this->dataPtr->statePublished = true;
+  this->dataPtr->publishedEnabled = this->dataPtr->enabled;
+  this->dataPtr->publishedAttached = this->dataPtr->attached;
+  this->dataPtr->lastStatePublishTime = now;
+  this->Publish();
+}
+
 /////////////////////////////////////////////////
 void VacuumGripperPlugin::Enable()
 {
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (!this->dataPtr->enabled && !this->dataPtr->attached)
+  {
+    // A new grasp starts
+    std::lock_guard<std::mutex> statsLock(this->dataPtr->statsMutex);
+    this->dataPtr->currentGrasp = VacuumGripperGrasp();
+    this->dataPtr->currentGrasp.enableTime = this->dataPtr->world->SimTime();
+  }
   this->dataPtr->enabled = true;
 }
 
@@ -434,7 +715,7 @@ void VacuumGripperPlugin::Disable()
 /////////////////////////////////////////////////
 void VacuumGripperPlugin::OnUpdate()
 {
-  this->Publish();
+  this->PublishIfNeeded();
 
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
   if (this->dataPtr->disableRequested)
@@ -444,13 +725,24 @@ void VacuumGripperPlugin::OnUpdate()
     this->dataPtr->disableRequested = false;
   }
 
+  if (!this->dataPtr->enabled)
+  {
+    return;
+  }
+
   if (this->dataPtr->world->SimTime() -
-      this->dataPtr->prevUpdateTime < this->dataPtr->updateRate ||
-      !this->dataPtr->enabled)
+      this->dataPtr->prevUpdateTime < this->dataPtr->updateRate)
   {
+    std::lock_guard<std::mutex> statsLock(this->dataPtr->statsMutex);
+    this->dataPtr->stats.gatedUpdates++;
     return;
   }
 
+  {
+    std::lock_guard<std::mutex> statsLock(this->dataPtr->statsMutex);
+    this->dataPtr->stats.evaluatedUpdates++;
+  }
+
   bool modelInContact = this->CheckModelContact();
   if (modelInContact)
   {
@@ -459,33 +751,22 @@ void VacuumGripperPlugin::OnUpdate()
 
   if (this->dataPtr->attached && this->dataPtr->dropPending)
   {
-    for (const auto dropObject : this->dataPtr->objectsToDrop)
+    // dropAttachedModel is of attachedObjType, and has drops of that type
+    // (see HandleAttach)
+    const auto worldObjPose = this->dataPtr->dropAttachedModel->WorldPose();
+    for (auto index : this->dataPtr->dropsByType[this->dataPtr->attachedObjType])
     {
-      if (dropObject.type != this->dataPtr->attachedObjType)
-      {
-        continue;
-      }
-
-      // Check that dropAttachedModel is of attachedObjType
-      auto name = this->dataPtr->dropAttachedModel->GetName();
-      std::string objectType = ariac::DetermineModelType(name);
-      if (objectType != this->dataPtr->attachedObjType)
-      {
-        gzdbg << "dropAttachedModel and attachedObjType are different: " << objectType << " and "
-              << this->dataPtr->attachedObjType << std::endl;
-        continue;
-      }
+      const auto &dropObject = this->dataPtr->objectsToDrop[index];
 
-      auto objPose = this->dataPtr->dropAttachedModel->WorldPose();
-      ignition::math::Pose3d dropFramePose;
+      auto objPose = worldObjPose;
       ignition::math::Matrix4d dropFrameTransMat;
       if (dropObject.frame)
       {
         // Transform the pose of the object from world frame to the specified frame.
-        dropFramePose = dropObject.frame->WorldPose();
-        dropFrameTransMat = ignition::math::Matrix4d(dropFramePose);
+        const auto &frame = this->dataPtr->FrameTransform(dropObject.frame);
+        dropFrameTransMat = frame.transform;
         ignition::math::Matrix4d objPoseWorld(objPose);
-        objPose = (dropFrameTransMat.Inverse() * objPoseWorld).Pose();
+        objPose = (frame.inverse * objPoseWorld).Pose();
       }
 
       if (!dropObject.dropRegion.Contains(objPose.Pos()))
@@ -509,7 +790,7 @@ void VacuumGripperPlugin::OnUpdate()
       this->dataPtr->dropAttachedModel->SetLinearVel(ignition::math::Vector3d::Zero);
       this->dataPtr->dropAttachedModel->SetLinearAccel(ignition::math::Vector3d::Zero);
 
-      this->dataPtr->droppedObjects.push_back(this->dataPtr->attachedObjType);
+      this->dataPtr->droppedObjects.insert(this->dataPtr->attachedObjType);
 
       this->dataPtr->dropPending = false;
       gzdbg << "Object dropped and teleported" << std::endl;
@@ -530,22 +811,55 @@ void VacuumGripperPlugin::OnUpdate()
 void VacuumGripperPlugin::OnContacts(ConstContactsPtr &_msg)
 {
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
-  this->dataPtr->contacts.clear();
+  this->dataPtr->contactCount = 0;
   for (int i = 0; i < _msg->contact_size(); ++i)
   {
-    CollisionPtr collision1 = boost::dynamic_pointer_cast<Collision>(
-        this->dataPtr->world->EntityByName(_msg->contact(i).collision1()));
-    CollisionPtr collision2 = boost::dynamic_pointer_cast<Collision>(
-        this->dataPtr->world->EntityByName(_msg->contact(i).collision2()));
+    const auto &contact = _msg->contact(i);
+    if (contact.normal_size() == 0)
+      continue;
+
+    // The wrenches carry the ids of the collisions, which avoids walking the
+    // entity tree for the collisions already seen
+    uint32_t id1 = 0;
+    uint32_t id2 = 0;
+    if (contact.wrench_size() > 0)
+    {
+      id1 = contact.wrench(0).body_1_id();
+      id2 = contact.wrench(0).body_2_id();
+    }
+    CollisionPtr collision1 = this->dataPtr->ResolveCollision(id1, contact.collision1());
+    CollisionPtr collision2 = this->dataPtr->ResolveCollision(id2, contact.collision2());
 
     if ((collision1 && !collision1->IsStatic()) &&
         (collision2 && !collision2->IsStatic()))
     {
-      this->dataPtr->contacts.push_back(_msg->contact(i));
+      ignition::math::Vector3d normal = msgs::ConvertIgn(contact.normal(0));
+      if (this->dataPtr->suctionCollisions.count(collision1->GetId()))
+      {
+        this->dataPtr->AddContact(collision2, normal, contact.position_size());
+      }
+      else
+      {
+        // The gripper's collision is the second one -- frames are reversed
+        this->dataPtr->AddContact(collision1, -normal, contact.position_size());
+      }
     }
   }
 }
 
+/////////////////////////////////////////////////
+void VacuumGripperPlugin::OnContactRecords(const std::vector<ContactRecord> &_records)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->contactCount = 0;
+  for (const auto &record : _records)
+  {
+    // Records are oriented with the gripper's collision first
+    if (!record.collision->IsStatic() && !record.other->IsStatic())
+      this->dataPtr->AddContact(record.other, record.normal, record.count);
+  }
+}
+
 /////////////////////////////////////////////////
 bool VacuumGripperPlugin::GetContactNormal()
 {
@@ -554,31 +868,18 @@ bool VacuumGripperPlugin::GetContactNormal()
 
   // Get the pointer to the collision that's not the gripper's.
   // This function is only called from the OnUpdate function so
-  // the call to contacts.clear() is not going to happen in
+  // the contact buffer is not going to be refilled in
   // parallel with the reads in the following code, no mutex needed.
-  for (unsigned int i = 0; i < this->dataPtr->contacts.size(); ++i)
+  size_t count = std::min(this->dataPtr->contactCount, kMaxGripperContacts);
+  for (size_t i = 0; i < count; ++i)
   {
-    std::string name1 = this->dataPtr->contacts[i].collision1();
-    std::string name2 = this->dataPtr->contacts[i].collision2();
-    gzdbg << "Collision between '" << name1 << "' and '" << name2 << "'\n";
+    const auto &contact = this->dataPtr->contacts[i];
 
-    if (this->dataPtr->collisions.find(name1) ==
-        this->dataPtr->collisions.end())
+    // Contacts are stored in the frame of the gripper
+    if (!this->dataPtr->suctionCollisions.count(contact.other->GetId()))
     {
-      // Model in contact is the second name
-      this->dataPtr->modelCollision = boost::dynamic_pointer_cast<Collision>(
-        this->dataPtr->world->EntityByName(name1));
-      this->dataPtr->modelContactNormal = -1 * msgs::ConvertIgn(this->dataPtr->contacts[i].normal(0));
-      return true;
-    }
-
-    if (this->dataPtr->collisions.find(name2) ==
-        this->dataPtr->collisions.end())
-    {
-      // Model in contact is the first name -- frames are reversed
-      this->dataPtr->modelCollision = boost::dynamic_pointer_cast<Collision>(
-        this->dataPtr->world->EntityByName(name2));
-      this->dataPtr->modelContactNormal = msgs::ConvertIgn(this->dataPtr->contacts[i].normal(0));
+      this->dataPtr->modelCollision = contact.other;
+      this->dataPtr->modelContactNormal = contact.normal;
       return true;
     }
   }
@@ -599,6 +900,12 @@ void VacuumGripperPlugin::HandleAttach()
     return;
   }
   this->dataPtr->attached = true;
+  this->dataPtr->attachTime = this->dataPtr->world->SimTime();
+  {
+    std::lock_guard<std::mutex> statsLock(this->dataPtr->statsMutex);
+    this->dataPtr->currentGrasp.attachTime = this->dataPtr->attachTime;
+  }
+  this->PublishStats();
 
   this->dataPtr->fixedJoint->Load(this->dataPtr->suctionCupLink,
       this->dataPtr->modelCollision->GetLink(), ignition::math::Pose3d());
@@ -614,20 +921,14 @@ void VacuumGripperPlugin::HandleAttach()
   this->dataPtr->dropAttachedModel.reset();
 
   // Check if the object should drop.
-  auto it = find_if(this->dataPtr->objectsToDrop.begin(), this->dataPtr->objectsToDrop.end(),
-    [&objectType](const VacuumGripperPluginPrivate::DropObject& obj) {
-      return obj.getType() == objectType;
-    });
   this->dataPtr->attachedObjType = objectType;
-  bool objectToBeDropped = it != this->dataPtr->objectsToDrop.end();
+  bool objectToBeDropped = this->dataPtr->dropsByType.count(objectType) > 0;
 
   if (!objectToBeDropped)
   {
     return;
   }
-  auto found = std::find(std::begin(this->dataPtr->droppedObjects),
-                 std::end(this->dataPtr->droppedObjects), this->dataPtr->attachedObjType);
-  bool alreadyDropped = found != std::end(this->dataPtr->droppedObjects);
+  bool alreadyDropped = this->dataPtr->droppedObjects.count(this->dataPtr->attachedObjType) > 0;
   if (!alreadyDropped)
   {
     this->dataPtr->dropPending = true;
@@ -640,19 +941,47 @@ void VacuumGripperPlugin::HandleAttach()
 void VacuumGripperPlugin::HandleDetach()
 {
   gzdbg << "Detaching product from gripper." << std::endl;
+  bool wasAttached = this->dataPtr->attached;
+  if (wasAttached)
+    this->dataPtr->detachTime = this->dataPtr->world->SimTime();
   this->dataPtr->attached = false;
   this->dataPtr->fixedJoint->Detach();
+
+  if (wasAttached)
+  {
+    {
+      std::lock_guard<std::mutex> statsLock(this->dataPtr->statsMutex);
+      this->dataPtr->currentGrasp.detachTime = this->dataPtr->detachTime;
+      this->dataPtr->stats.grasps.push_back(this->dataPtr->currentGrasp);
+
+      // If the suction stays on, the next grasp starts now
+      this->dataPtr->currentGrasp = VacuumGripperGrasp();
+      this->dataPtr->currentGrasp.enableTime = this->dataPtr->detachTime;
+    }
+    this->PublishStats();
+  }
 }
 
 /////////////////////////////////////////////////
 bool VacuumGripperPlugin::CheckModelContact()
 {
   bool modelInContact = false;
-  if (this->dataPtr->contacts.size() > 0)
+  if (this->dataPtr->contactCount > 0)
   {
-    gzdbg << "Number of collisions with gripper: " << this->dataPtr->contacts.size() << std::endl;
+    gzdbg << "Number of collisions with gripper: " << this->dataPtr->contactCount << std::endl;
   }
-  if (this->dataPtr->contacts.size() >= this->dataPtr->minContactCount)
+  {
+    std::lock_guard<std::mutex> statsLock(this->dataPtr->statsMutex);
+    auto &histogram = this->dataPtr->stats.contactHistogram;
+    histogram[std::min(this->dataPtr->contactCount, histogram.size() - 1)]++;
+    if (this->dataPtr->contactCount >= this->dataPtr->minContactCount &&
+        !this->dataPtr->attached &&
+        this->dataPtr->currentGrasp.firstContactTime == common::Time::Zero)
+    {
+      this->dataPtr->currentGrasp.firstContactTime = this->dataPtr->world->SimTime();
+    }
+  }
+  if (this->dataPtr->contactCount >= this->dataPtr->minContactCount)
   {
     gzdbg << "More collisions than the minContactCount: " << this->dataPtr->minContactCount << std::endl;
     this->dataPtr->posCount++;
@@ -707,3 +1036,8 @@ bool VacuumGripperPlugin::CheckModelContact()
 void VacuumGripperPlugin::Publish() const
 {
 }
+
+/////////////////////////////////////////////////
+void VacuumGripperPlugin::PublishStats() const
+{
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cstdint>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <ignition/math/Angle.hh>
+#include <ignition/math/Box.hh>
+#include <ignition/math/Frustum.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+
+#include "nist_gear/LogicalPerceptionEngine.hh"
+
+using gazebo::LogicalCameraFrustum;
+using gazebo::LogicalCameraParams;
+using gazebo::LogicalPerceptionEngine;
+
+/// \brief Parameters of a camera like the ARIAC logical cameras
+LogicalCameraParams make_params()
+{
+  LogicalCameraParams params;
+  params.nearClip = 0.2;
+  params.farClip = 1.5;
+  params.horizontalFov = 1.05;
+  params.aspectRatio = 1.8;
+  return params;
+}
+
+/// \brief Random pose of the camera around the origin
+ignition::math::Pose3d random_pose(std::mt19937 &gen)
+{
+  std::uniform_real_distribution<double> position(-3.0, 3.0);
+  std::uniform_real_distribution<double> angle(-3.14, 3.14);
+  return ignition::math::Pose3d(position(gen), position(gen), position(gen),
+                                angle(gen), angle(gen) / 2.0, angle(gen));
+}
+
+/// \brief Random box around the origin
+ignition::math::Box random_box(std::mt19937 &gen)
+{
+  std::uniform_real_distribution<double> position(-4.0, 4.0);
+  std::uniform_real_distribution<double> size(0.0, 0.4);
+  ignition::math::Vector3d min(position(gen), position(gen), position(gen));
+  ignition::math::Vector3d max = min + ignition::math::Vector3d(size(gen), size(gen), size(gen));
+  return ignition::math::Box(min, max);
+}
+
+/// \brief Whether the frustum flags a box as outside
+bool flagged_outside(const LogicalCameraFrustum &frustum, const ignition::math::Box &box)
+{
+  const double min[3] = {box.Min().X(), box.Min().Y(), box.Min().Z()};
+  const double max[3] = {box.Max().X(), box.Max().Y(), box.Max().Z()};
+  const double *const minArrays[3] = {&min[0], &min[1], &min[2]};
+  const double *const maxArrays[3] = {&max[0], &max[1], &max[2]};
+  uint8_t outside = 0;
+  frustum.FlagOutside(1, minArrays, maxArrays, &outside);
+  return outside != 0;
+}
+
+/// \brief Frustum computed by ignition, as used by the logical camera sensor
+ignition::math::Frustum make_reference(const LogicalCameraParams &params,
+                                       const ignition::math::Pose3d &pose)
+{
+  return ignition::math::Frustum(params.nearClip, params.farClip,
+                                 ignition::math::Angle(params.horizontalFov),
+                                 params.aspectRatio, pose);
+}
+
+TEST(TestLogicalPerception, BoxesMatchIgnitionFrustum)
+{
+  std::mt19937 gen(42);
+  LogicalCameraParams params = make_params();
+  int inside = 0;
+  for (int p = 0; p < 20; ++p)
+  {
+    ignition::math::Pose3d pose = random_pose(gen);
+    LogicalCameraFrustum frustum(params, pose);
+    ignition::math::Frustum reference = make_reference(params, pose);
+    for (int b = 0; b < 500; ++b)
+    {
+      ignition::math::Box box = random_box(gen);
+      bool contained = reference.Contains(box);
+      EXPECT_EQ(!contained, flagged_outside(frustum, box))
+        << "pose: " << pose << " box: " << box.Min() << " " << box.Max();
+      inside += contained;
+    }
+  }
+  // Make sure that both outcomes were exercised
+  EXPECT_GT(inside, 0);
+}
+
+TEST(TestLogicalPerception, PointsMatchIgnitionFrustum)
+{
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> position(-2.0, 2.0);
+  LogicalCameraParams params = make_params();
+  ignition::math::Pose3d pose(0.5, -0.3, 1.2, 0, 0.6, 1.0);
+  LogicalCameraFrustum frustum(params, pose);
+  ignition::math::Frustum reference = make_reference(params, pose);
+  for (int i = 0; i < 2000; ++i)
+  {
+    ignition::math::Vector3d point(position(gen), position(gen), position(gen));
+    EXPECT_EQ(!reference.Contains(point),
+              flagged_outside(frustum, ignition::math::Box(point, point)))
+      << "point: " << point;
+  }
+}
+
+TEST(TestLogicalPerception, GridQueryCoversVisibleBoxes)
+{
+  std::mt19937 gen(3);
+  LogicalCameraParams params = make_params();
+  for (double cellSize : {0.25, 0.5, 1.0})
+  {
+    for (int p = 0; p < 20; ++p)
+    {
+      ignition::math::Pose3d pose = random_pose(gen);
+      LogicalCameraFrustum frustum(params, pose);
+      ignition::math::Frustum reference = make_reference(params, pose);
+      int queryMin[3];
+      int queryMax[3];
+      LogicalPerceptionEngine::CellRange(
+        frustum.Min(), frustum.Max(), cellSize, queryMin, queryMax);
+
+      for (int b = 0; b < 500; ++b)
+      {
+        ignition::math::Box box = random_box(gen);
+        if (!reference.Contains(box))
+          continue;
+        // A visible box must be binned in at least one of the queried cells
+        int boxMin[3];
+        int boxMax[3];
+        LogicalPerceptionEngine::CellRange(box.Min(), box.Max(), cellSize, boxMin, boxMax);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          EXPECT_LE(boxMin[axis], queryMax[axis]) << "box: " << box.Min() << " " << box.Max();
+          EXPECT_GE(boxMax[axis], queryMin[axis]) << "box: " << box.Min() << " " << box.Max();
+        }
+      }
+    }
+  }
+}
+
+TEST(TestLogicalPerception, CellRangeOfNegativeCoordinates)
+{
+  int cellMin[3];
+  int cellMax[3];
+  LogicalPerceptionEngine::CellRange(ignition::math::Vector3d(-0.1, -1.0, 0.0),
+                                     ignition::math::Vector3d(0.1, -0.6, 0.49),
+                                     0.5, cellMin, cellMax);
+  EXPECT_EQ(-1, cellMin[0]);
+  EXPECT_EQ(0, cellMax[0]);
+  EXPECT_EQ(-2, cellMin[1]);
+  EXPECT_EQ(-2, cellMax[1]);
+  EXPECT_EQ(0, cellMin[2]);
+  EXPECT_EQ(0, cellMax[2]);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}